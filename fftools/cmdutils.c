@@ -94,6 +94,9 @@ void uninit_opts(void)
     av_dict_free(&format_opts);
     av_dict_free(&codec_opts);
     av_dict_free(&resample_opts);
+
+    /* write out messages still queued by the asynchronous logger */
+    av_log_set_flags(av_log_get_flags() & ~AV_LOG_ASYNC);
 }
 
 void log_callback_help(void *ptr, int level, const char *fmt, va_list vl)
@@ -138,6 +141,9 @@ void exit_program(int ret)
     if (program_exit)
         program_exit(ret);
 
+    /* write out messages still queued by the asynchronous logger */
+    av_log_set_flags(av_log_get_flags() & ~AV_LOG_ASYNC);
+
     exit(ret);
 }
 
@@ -912,6 +918,13 @@ int opt_loglevel(void *optctx, const char *opt, const char *arg)
                 flags |= AV_LOG_PRINT_LEVEL;
             }
             arg = token + 5;
+        } else if (!strncmp(token, "async", 5)) {
+            if (cmd == '-') {
+                flags &= ~AV_LOG_ASYNC;
+            } else {
+                flags |= AV_LOG_ASYNC;
+            }
+            arg = token + 5;
         } else {
             break;
         }
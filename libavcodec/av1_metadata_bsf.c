@@ -46,6 +46,8 @@ typedef struct AV1MetadataContext {
 
     AVRational tick_rate;
     int num_ticks_per_picture;
+
+    int passthrough_units;
 } AV1MetadataContext;
 
 
@@ -179,6 +181,10 @@ fail:
     return err;
 }
 
+static CodedBitstreamUnitType av1_metadata_decompose_types[] = {
+    AV1_OBU_SEQUENCE_HEADER,
+};
+
 static int av1_metadata_init(AVBSFContext *bsf)
 {
     AV1MetadataContext *ctx = bsf->priv_data;
@@ -190,6 +196,13 @@ static int av1_metadata_init(AVBSFContext *bsf)
     if (err < 0)
         return err;
 
+    // Only the sequence header is modified, pass everything else through.
+    if (ctx->passthrough_units) {
+        ctx->cbc->decompose_unit_types    = av1_metadata_decompose_types;
+        ctx->cbc->nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(av1_metadata_decompose_types);
+    }
+
     if (bsf->par_in->extradata) {
         err = ff_cbs_read_extradata(ctx->cbc, frag, bsf->par_in);
         if (err < 0) {
@@ -273,6 +286,11 @@ static const AVOption av1_metadata_options[] = {
         OFFSET(num_ticks_per_picture), AV_OPT_TYPE_INT,
         { .i64 = -1 }, -1, INT_MAX, FLAGS },
 
+    { "passthrough_units", "Only parse the units which are modified, "
+        "pass all others through unchanged",
+        OFFSET(passthrough_units), AV_OPT_TYPE_BOOL,
+        { .i64 = 0 }, 0, 1, FLAGS },
+
     { NULL }
 };
 
@@ -82,6 +82,8 @@ typedef struct H264MetadataContext {
     int flip;
 
     int level;
+
+    int passthrough_units;
 } H264MetadataContext;
 
 
@@ -614,6 +616,10 @@ fail:
     return err;
 }
 
+static CodedBitstreamUnitType h264_metadata_sps_only[] = {
+    H264_NAL_SPS,
+};
+
 static int h264_metadata_init(AVBSFContext *bsf)
 {
     H264MetadataContext *ctx = bsf->priv_data;
@@ -624,6 +630,16 @@ static int h264_metadata_init(AVBSFContext *bsf)
     if (err < 0)
         return err;
 
+    // Only the SPS needs to be decomposed unless slices or SEI messages
+    // are inspected; all other NAL units are passed through unparsed.
+    if (ctx->passthrough_units &&
+        ctx->aud != INSERT && !ctx->sei_user_data &&
+        !ctx->delete_filler && ctx->display_orientation == PASS) {
+        ctx->cbc->decompose_unit_types    = h264_metadata_sps_only;
+        ctx->cbc->nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(h264_metadata_sps_only);
+    }
+
     if (bsf->par_in->extradata) {
         err = ff_cbs_read_extradata(ctx->cbc, au, bsf->par_in);
         if (err < 0) {
@@ -776,6 +792,11 @@ static const AVOption h264_metadata_options[] = {
     { LEVEL("6.2", 62) },
 #undef LEVEL
 
+    { "passthrough_units", "Only parse the units which are modified, "
+        "pass all others through unchanged",
+        OFFSET(passthrough_units), AV_OPT_TYPE_BOOL,
+        { .i64 = 0 }, 0, 1, FLAGS },
+
     { NULL }
 };
 
@@ -2525,9 +2525,11 @@ static void predict_field_decoding_flag(const H264Context *h, H264SliceContext *
 }
 
 /**
- * Draw edges and report progress for the last MB row.
+ * Compute the band of lines which is final once the last MB row is done.
+ * @return 0 if there is no such band
  */
-static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
+static int finished_row_band(const H264Context *h, const H264SliceContext *sl,
+                             int *ptop, int *pheight)
 {
     int top            = 16 * (sl->mb_y      >> FIELD_PICTURE(h));
     int pic_height     = 16 *  h->mb_height >> FIELD_PICTURE(h);
@@ -2541,7 +2543,7 @@ static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
     }
 
     if (top >= pic_height || (top + height) < 0)
-        return;
+        return 0;
 
     height = FFMIN(height, pic_height - top);
     if (top < 0) {
@@ -2549,7 +2551,25 @@ static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
         top    = 0;
     }
 
-    ff_h264_draw_horiz_band(h, sl, top, height);
+    *ptop    = top;
+    *pheight = height;
+    return 1;
+}
+
+/**
+ * Draw edges and report progress for the last MB row.
+ */
+static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
+{
+    int top, height;
+
+    if (!finished_row_band(h, sl, &top, &height))
+        return;
+
+    /* Concurrent slices finish their rows out of order, their bands are
+     * drawn by ff_h264_execute_decode_slices() once all of them are done. */
+    if (h->nb_slice_ctx_queued == 1)
+        ff_h264_draw_horiz_band(h, sl, top, height);
 
     if (h->droppable || sl->h264->slice_ctx[0].er.error_occurred)
         return;
@@ -2840,6 +2860,8 @@ int ff_h264_execute_decode_slices(H264Context *h)
         /* pull back stuff from slices to master context */
         sl                   = &h->slice_ctx[context_count - 1];
         h->mb_y              = sl->mb_y;
+        for (i = 0; i < context_count; i++)
+            h->slice_ctx[i].end_mb_y = h->slice_ctx[i].mb_y;
         if (CONFIG_ERROR_RESILIENCE) {
             for (i = 1; i < context_count; i++)
                 h->slice_ctx[0].er.error_count += h->slice_ctx[i].er.error_count;
@@ -2862,6 +2884,22 @@ int ff_h264_execute_decode_slices(H264Context *h)
                 }
             }
         }
+
+        if (avctx->draw_horiz_band) {
+            for (i = 0; i < context_count; i++) {
+                int top, height, mb_y = h->slice_ctx[i].mb_y;
+
+                sl = &h->slice_ctx[i];
+
+                /* a row belongs to the slice which decoded its last MB */
+                for (j = sl->resync_mb_y; j < sl->end_mb_y; j += 1 + FIELD_OR_MBAFF_PICTURE(h)) {
+                    sl->mb_y = j;
+                    if (finished_row_band(h, sl, &top, &height))
+                        ff_h264_draw_horiz_band(h, sl, top, height);
+                }
+                sl->mb_y = mb_y;
+            }
+        }
     }
 
 finish:
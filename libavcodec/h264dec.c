@@ -117,6 +117,13 @@ void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl,
     if (field_pic && h->first_field && !(avctx->slice_flags & SLICE_FLAG_ALLOW_FIELD))
         return;
 
+    /* The bands are drawn in decoding order, which only matches the output
+     * order if the SPS rules out frame reordering. Without the VUI bitstream
+     * restrictions has_b_frames is only a guess which may still grow. */
+    if (!(avctx->slice_flags & SLICE_FLAG_CODED_ORDER) &&
+        (avctx->has_b_frames || !h->ps.sps->bitstream_restriction_flag))
+        return;
+
     if (avctx->draw_horiz_band) {
         int offset[AV_NUM_DATA_POINTERS];
         int i;
@@ -1051,7 +1058,7 @@ AVCodec ff_h264_decoder = {
     .init                  = h264_decode_init,
     .close                 = h264_decode_end,
     .decode                = h264_decode_frame,
-    .capabilities          = /*AV_CODEC_CAP_DRAW_HORIZ_BAND |*/ AV_CODEC_CAP_DR1 |
+    .capabilities          = AV_CODEC_CAP_DRAW_HORIZ_BAND | AV_CODEC_CAP_DR1 |
                              AV_CODEC_CAP_DELAY | AV_CODEC_CAP_SLICE_THREADS |
                              AV_CODEC_CAP_FRAME_THREADS,
     .hw_configs            = (const AVCodecHWConfigInternal*[]) {
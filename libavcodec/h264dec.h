@@ -234,6 +234,8 @@ typedef struct H264SliceContext {
     unsigned int first_mb_addr;
     // index of the first MB of the next slice
     int next_slice_idx;
+    // mb_y reached by the last decode_slice() call
+    int end_mb_y;
     int mb_skip_run;
     int is_complex;
 
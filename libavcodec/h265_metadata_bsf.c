@@ -58,6 +58,8 @@ typedef struct H265MetadataContext {
     int crop_right;
     int crop_top;
     int crop_bottom;
+
+    int passthrough_units;
 } H265MetadataContext;
 
 
@@ -331,6 +333,11 @@ fail:
     return err;
 }
 
+static CodedBitstreamUnitType h265_metadata_ps_only[] = {
+    HEVC_NAL_VPS,
+    HEVC_NAL_SPS,
+};
+
 static int h265_metadata_init(AVBSFContext *bsf)
 {
     H265MetadataContext *ctx = bsf->priv_data;
@@ -341,6 +348,15 @@ static int h265_metadata_init(AVBSFContext *bsf)
     if (err < 0)
         return err;
 
+    // Only the parameter sets need to be decomposed unless an AUD is
+    // generated from the slices; all other NAL units are passed through
+    // unparsed.
+    if (ctx->passthrough_units && ctx->aud != INSERT) {
+        ctx->cbc->decompose_unit_types    = h265_metadata_ps_only;
+        ctx->cbc->nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(h265_metadata_ps_only);
+    }
+
     if (bsf->par_in->extradata) {
         err = ff_cbs_read_extradata(ctx->cbc, au, bsf->par_in);
         if (err < 0) {
@@ -439,6 +455,11 @@ static const AVOption h265_metadata_options[] = {
         OFFSET(crop_bottom), AV_OPT_TYPE_INT,
         { .i64 = -1 }, -1, HEVC_MAX_HEIGHT, FLAGS },
 
+    { "passthrough_units", "Only parse the units which are modified, "
+        "pass all others through unchanged",
+        OFFSET(passthrough_units), AV_OPT_TYPE_BOOL,
+        { .i64 = 0 }, 0, 1, FLAGS },
+
     { NULL }
 };
 
@@ -24,6 +24,7 @@
 
 #include "libavutil/common.h"
 #include "libavutil/internal.h"
+#include "libavutil/thread.h"
 
 #include "cabac_functions.h"
 #include "hevcdec.h"
@@ -243,10 +244,9 @@ static void restore_tqb_pixels(HEVCContext *s,
 
 #define CTB(tab, x, y) ((tab)[(y) * s->ps.sps->ctb_width + (x)])
 
-static void sao_filter_CTB(HEVCContext *s, int x, int y)
+static void sao_filter_CTB(HEVCContext *s, HEVCLocalContext *lc, int x, int y)
 {
     static const uint8_t sao_tab[8] = { 0, 1, 2, 2, 3, 3, 4, 4 };
-    HEVCLocalContext *lc = s->HEVClc;
     int c_idx;
     int edges[4];  // 0 left 1 top 2 right 3 bottom
     int x_ctb                = x >> s->ps.sps->log2_ctb_size;
@@ -839,7 +839,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
 #undef CB
 #undef CR
 
-void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
+static void hls_filter(HEVCContext *s, HEVCLocalContext *lc, int x, int y, int ctb_size)
 {
     int x_end = x >= s->ps.sps->width  - ctb_size;
     int skip = 0;
@@ -858,16 +858,16 @@ void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
     if (s->ps.sps->sao_enabled && !skip) {
         int y_end = y >= s->ps.sps->height - ctb_size;
         if (y && x)
-            sao_filter_CTB(s, x - ctb_size, y - ctb_size);
+            sao_filter_CTB(s, lc, x - ctb_size, y - ctb_size);
         if (x && y_end)
-            sao_filter_CTB(s, x - ctb_size, y);
+            sao_filter_CTB(s, lc, x - ctb_size, y);
         if (y && x_end) {
-            sao_filter_CTB(s, x, y - ctb_size);
+            sao_filter_CTB(s, lc, x, y - ctb_size);
             if (s->threads_type & FF_THREAD_FRAME )
                 ff_thread_report_progress(&s->ref->tf, y, 0);
         }
         if (x_end && y_end) {
-            sao_filter_CTB(s, x , y);
+            sao_filter_CTB(s, lc, x , y);
             if (s->threads_type & FF_THREAD_FRAME )
                 ff_thread_report_progress(&s->ref->tf, y + ctb_size, 0);
         }
@@ -875,14 +875,216 @@ void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
         ff_thread_report_progress(&s->ref->tf, y + ctb_size - 4, 0);
 }
 
-void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size)
+static void hls_filters(HEVCContext *s, HEVCLocalContext *lc, int x_ctb, int y_ctb, int ctb_size)
 {
     int x_end = x_ctb >= s->ps.sps->width  - ctb_size;
     int y_end = y_ctb >= s->ps.sps->height - ctb_size;
     if (y_ctb && x_ctb)
-        ff_hevc_hls_filter(s, x_ctb - ctb_size, y_ctb - ctb_size, ctb_size);
+        hls_filter(s, lc, x_ctb - ctb_size, y_ctb - ctb_size, ctb_size);
     if (y_ctb && x_end)
-        ff_hevc_hls_filter(s, x_ctb, y_ctb - ctb_size, ctb_size);
+        hls_filter(s, lc, x_ctb, y_ctb - ctb_size, ctb_size);
     if (x_ctb && y_end)
-        ff_hevc_hls_filter(s, x_ctb - ctb_size, y_ctb, ctb_size);
+        hls_filter(s, lc, x_ctb - ctb_size, y_ctb, ctb_size);
+}
+
+void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
+{
+    hls_filter(s, s->HEVClc, x, y, ctb_size);
+}
+
+void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size)
+{
+    hls_filters(s, s->HEVClc, x_ctb, y_ctb, ctb_size);
+}
+
+/*
+ * Loop filter pipeline.
+ *
+ * ff_hevc_hls_filters() only touches samples which the reconstruction of the
+ * following CTBs no longer reads, so the exact same sequence of filter calls
+ * can be replayed by a worker thread trailing the reconstruction by any
+ * number of CTBs. Each slice is drained before returning, so the slice
+ * header and the per-picture state stay constant while the worker runs.
+ */
+typedef struct HEVCFilterJob {
+    int x_ctb;
+    int y_ctb;
+    int last;
+} HEVCFilterJob;
+
+typedef struct HEVCFilterPipeline {
+    HEVCContext *s;
+    HEVCLocalContext *lc;   ///< edge emulation scratch of the worker
+
+    HEVCFilterJob *jobs;
+    unsigned int jobs_allocated;
+    int nb_queued;
+    int nb_done;
+    int ctb_size;
+
+#if HAVE_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int quit;
+#endif
+} HEVCFilterPipeline;
+
+#if HAVE_THREADS
+static void *filter_pipeline_worker(void *arg)
+{
+    HEVCFilterPipeline *p = arg;
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->quit) {
+        int i, nb_queued = p->nb_queued;
+
+        if (p->nb_done == nb_queued) {
+            pthread_cond_wait(&p->cond, &p->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        for (i = p->nb_done; i < nb_queued; i++) {
+            const HEVCFilterJob *job = &p->jobs[i];
+            if (job->last)
+                hls_filter(p->s, p->lc, job->x_ctb, job->y_ctb, p->ctb_size);
+            else
+                hls_filters(p->s, p->lc, job->x_ctb, job->y_ctb, p->ctb_size);
+        }
+
+        pthread_mutex_lock(&p->lock);
+        p->nb_done = nb_queued;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+static int filter_pipeline_init(HEVCContext *s)
+{
+    HEVCFilterPipeline *p;
+    int ret;
+
+    p = av_mallocz(sizeof(*p));
+    if (!p)
+        return AVERROR(ENOMEM);
+    p->s  = s;
+    p->lc = av_mallocz(sizeof(*p->lc));
+    if (!p->lc) {
+        av_free(p);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = pthread_mutex_init(&p->lock, NULL))) {
+        av_free(p->lc);
+        av_free(p);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&p->cond, NULL))) {
+        pthread_mutex_destroy(&p->lock);
+        av_free(p->lc);
+        av_free(p);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&p->thread, NULL, filter_pipeline_worker, p))) {
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->lock);
+        av_free(p->lc);
+        av_free(p);
+        return AVERROR(ret);
+    }
+
+    s->filter_pipeline = p;
+    return 0;
+}
+#endif
+
+int ff_hevc_filter_pipeline_start(HEVCContext *s)
+{
+#if HAVE_THREADS
+    HEVCFilterPipeline *p;
+    int enable = s->loop_filter_thread;
+    int ret;
+
+    if (enable < 0)
+        enable = s->threads_type == FF_THREAD_SLICE && s->threads_number > 1;
+    if (!enable)
+        return 0;
+
+    if (!s->filter_pipeline && (ret = filter_pipeline_init(s)) < 0)
+        return ret;
+    p = s->filter_pipeline;
+
+    /* at most one job per CTB of the slice, plus the final one */
+    av_fast_malloc(&p->jobs, &p->jobs_allocated,
+                   (s->ps.sps->ctb_size + 1) * sizeof(*p->jobs));
+    if (!p->jobs)
+        return AVERROR(ENOMEM);
+
+    pthread_mutex_lock(&p->lock);
+    p->nb_queued = 0;
+    p->nb_done   = 0;
+    p->ctb_size  = 1 << s->ps.sps->log2_ctb_size;
+    pthread_mutex_unlock(&p->lock);
+
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void ff_hevc_filter_pipeline_push(HEVCContext *s, int x_ctb, int y_ctb, int last)
+{
+#if HAVE_THREADS
+    HEVCFilterPipeline *p = s->filter_pipeline;
+    HEVCFilterJob *job;
+
+    pthread_mutex_lock(&p->lock);
+    job = &p->jobs[p->nb_queued];
+    job->x_ctb = x_ctb;
+    job->y_ctb = y_ctb;
+    job->last  = last;
+    p->nb_queued++;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+void ff_hevc_filter_pipeline_finish(HEVCContext *s)
+{
+#if HAVE_THREADS
+    HEVCFilterPipeline *p = s->filter_pipeline;
+
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    while (p->nb_done < p->nb_queued)
+        pthread_cond_wait(&p->cond, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+void ff_hevc_filter_pipeline_uninit(HEVCContext *s)
+{
+#if HAVE_THREADS
+    HEVCFilterPipeline *p = s->filter_pipeline;
+
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    av_freep(&p->jobs);
+    av_freep(&p->lc);
+    av_freep(&s->filter_pipeline);
+#endif
 }
@@ -2428,12 +2428,19 @@ static int hls_decode_entry(AVCodecContext *avctxt, void *isFilterThread)
 
         ctb_addr_ts++;
         ff_hevc_save_states(s, ctb_addr_ts);
-        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        if (s->filter_pipeline_active)
+            ff_hevc_filter_pipeline_push(s, x_ctb, y_ctb, 0);
+        else
+            ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
     }
 
     if (x_ctb + ctb_size >= s->ps.sps->width &&
-        y_ctb + ctb_size >= s->ps.sps->height)
-        ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+        y_ctb + ctb_size >= s->ps.sps->height) {
+        if (s->filter_pipeline_active)
+            ff_hevc_filter_pipeline_push(s, x_ctb, y_ctb, 1);
+        else
+            ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+    }
 
     return ctb_addr_ts;
 }
@@ -2442,11 +2449,22 @@ static int hls_slice_data(HEVCContext *s)
 {
     int arg[2];
     int ret[2];
+    int pipelined;
 
     arg[0] = 0;
     arg[1] = 1;
 
+    pipelined = ff_hevc_filter_pipeline_start(s);
+    if (pipelined < 0)
+        return pipelined;
+    s->filter_pipeline_active = pipelined;
+
     s->avctx->execute(s->avctx, hls_decode_entry, arg, ret , 1, sizeof(int));
+
+    if (s->filter_pipeline_active) {
+        ff_hevc_filter_pipeline_finish(s);
+        s->filter_pipeline_active = 0;
+    }
     return ret[0];
 }
 static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int job, int self_id)
@@ -3271,6 +3289,8 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     HEVCContext       *s = avctx->priv_data;
     int i;
 
+    ff_hevc_filter_pipeline_uninit(s);
+
     pic_arrays_free(s);
 
     av_freep(&s->md5_ctx);
@@ -3484,9 +3504,11 @@ static av_cold int hevc_decode_init(AVCodecContext *avctx)
 static av_cold int hevc_init_thread_copy(AVCodecContext *avctx)
 {
     HEVCContext *s = avctx->priv_data;
+    int loop_filter_thread = s->loop_filter_thread;
     int ret;
 
     memset(s, 0, sizeof(*s));
+    s->loop_filter_thread = loop_filter_thread;
 
     ret = hevc_init_context(avctx);
     if (ret < 0)
@@ -3512,6 +3534,8 @@ static const AVOption options[] = {
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "loop_filter_thread", "Run the loop filters on a separate thread behind the reconstruction", OFFSET(loop_filter_thread),
+        AV_OPT_TYPE_BOOL, {.i64 = -1}, -1, 1, PAR },
     { NULL },
 };
 
@@ -481,6 +481,14 @@ typedef struct HEVCContext {
                             ///< as a format defined in 14496-15
     int apply_defdispwin;
 
+    /**
+     * Run deblocking and SAO of non-WPP slices on a separate thread trailing
+     * the reconstruction, -1 enables it whenever slice threading is used.
+     */
+    int loop_filter_thread;
+    struct HEVCFilterPipeline *filter_pipeline;
+    int filter_pipeline_active; ///< filters of the current slice are queued
+
     int nal_length_size;    ///< Number of bytes used for nal length (1, 2 or 4)
     int nuh_layer_id;
 } HEVCContext;
@@ -595,6 +603,24 @@ int ff_hevc_cu_chroma_qp_offset_flag(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_idx(HEVCContext *s);
 void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size);
 void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size);
+
+/**
+ * Prepare the loop filter pipeline for the slice about to be decoded.
+ * @return 1 if the filters of this slice should be queued with
+ *         ff_hevc_filter_pipeline_push(), 0 if they are to be run inline,
+ *         a negative error code on failure
+ */
+int  ff_hevc_filter_pipeline_start(HEVCContext *s);
+/**
+ * Queue the filters which ff_hevc_hls_filters() (or ff_hevc_hls_filter() for
+ * the last CTB of the picture, if last is set) would run at this point.
+ */
+void ff_hevc_filter_pipeline_push(HEVCContext *s, int x_ctb, int y_ctb, int last);
+/**
+ * Wait until all queued filters have been applied.
+ */
+void ff_hevc_filter_pipeline_finish(HEVCContext *s);
+void ff_hevc_filter_pipeline_uninit(HEVCContext *s);
 void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
                                  int log2_trafo_size, enum ScanType scan_idx,
                                  int c_idx);
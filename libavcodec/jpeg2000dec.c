@@ -87,6 +87,14 @@ typedef struct Jpeg2000Tile {
     int coord[2][2];                    // border coordinates {{x0, x1}, {y0, y1}}
 } Jpeg2000Tile;
 
+typedef struct Jpeg2000CblkJob {
+    Jpeg2000Component   *comp;
+    Jpeg2000CodingStyle *codsty;
+    Jpeg2000Band        *band;
+    Jpeg2000Cblk        *cblk;
+    int                 bandpos;
+} Jpeg2000CblkJob;
+
 typedef struct Jpeg2000DecoderContext {
     AVClass         *class;
     AVCodecContext  *avctx;
@@ -121,6 +129,11 @@ typedef struct Jpeg2000DecoderContext {
     Jpeg2000Tile    *tile;
     Jpeg2000DSPContext dsp;
 
+    /* code-blocks of the current tile, when decoding them in parallel */
+    Jpeg2000CblkJob *cblk_jobs;
+    unsigned int    cblk_jobs_size;
+    Jpeg2000Tile    *job_tile;
+
     /*options parameters*/
     int             reduction_factor;
 } Jpeg2000DecoderContext;
@@ -1684,11 +1697,95 @@ static inline void mct_decode(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
     s->dsp.mct_decode[tile->codsty[0].transform](src[0], src[1], src[2], csize);
 }
 
+static void decode_dequantize_cblk(Jpeg2000DecoderContext *s,
+                                   Jpeg2000T1Context *t1,
+                                   const Jpeg2000CblkJob *job)
+{
+    Jpeg2000Component *comp     = job->comp;
+    Jpeg2000CodingStyle *codsty = job->codsty;
+    Jpeg2000Band *band          = job->band;
+    Jpeg2000Cblk *cblk          = job->cblk;
+    int x, y;
+
+    decode_cblk(s, codsty, t1, cblk,
+                cblk->coord[0][1] - cblk->coord[0][0],
+                cblk->coord[1][1] - cblk->coord[1][0],
+                job->bandpos);
+
+    x = cblk->coord[0][0] - band->coord[0][0];
+    y = cblk->coord[1][0] - band->coord[1][0];
+
+    if (codsty->transform == FF_DWT97)
+        dequantization_float(x, y, cblk, comp, t1, band);
+    else if (codsty->transform == FF_DWT97_INT)
+        dequantization_int_97(x, y, cblk, comp, t1, band);
+    else
+        dequantization_int(x, y, cblk, comp, t1, band);
+}
+
+/**
+ * Walk the code-blocks of a tile component, decoding them if t1 is set
+ * and storing them in jobs if it is set.
+ * @return the number of code-blocks
+ */
+static int tile_comp_foreach_cblk(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile,
+                                  int compno, Jpeg2000T1Context *t1,
+                                  Jpeg2000CblkJob *jobs)
+{
+    Jpeg2000Component *comp     = tile->comp + compno;
+    Jpeg2000CodingStyle *codsty = tile->codsty + compno;
+    int reslevelno, bandno, nb_jobs = 0;
+
+    /* Loop on resolution levels */
+    for (reslevelno = 0; reslevelno < codsty->nreslevels2decode; reslevelno++) {
+        Jpeg2000ResLevel *rlevel = comp->reslevel + reslevelno;
+        /* Loop on bands */
+        for (bandno = 0; bandno < rlevel->nbands; bandno++) {
+            int nb_precincts, precno;
+            Jpeg2000Band *band = rlevel->band + bandno;
+            int cblkno = 0, bandpos;
+
+            bandpos = bandno + (reslevelno > 0);
+
+            if (band->coord[0][0] == band->coord[0][1] ||
+                band->coord[1][0] == band->coord[1][1])
+                continue;
+
+            nb_precincts = rlevel->num_precincts_x * rlevel->num_precincts_y;
+            /* Loop on precincts */
+            for (precno = 0; precno < nb_precincts; precno++) {
+                Jpeg2000Prec *prec = band->prec + precno;
+
+                /* Loop on codeblocks */
+                for (cblkno = 0;
+                     cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height;
+                     cblkno++) {
+                    Jpeg2000CblkJob job = {
+                        .comp    = comp,
+                        .codsty  = codsty,
+                        .band    = band,
+                        .cblk    = prec->cblk + cblkno,
+                        .bandpos = bandpos,
+                    };
+
+                    if (t1)
+                        decode_dequantize_cblk(s, t1, &job);
+                    if (jobs)
+                        jobs[nb_jobs] = job;
+                    nb_jobs++;
+                } /* end cblk */
+            } /*end prec */
+        } /* end band */
+    } /* end reslevel */
+
+    return nb_jobs;
+}
+
 static inline void tile_codeblocks(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
 {
     Jpeg2000T1Context t1;
 
-    int compno, reslevelno, bandno;
+    int compno;
 
     /* Loop on tile components */
     for (compno = 0; compno < s->ncomponents; compno++) {
@@ -1697,56 +1794,66 @@ static inline void tile_codeblocks(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile
 
         t1.stride = (1<<codsty->log2_cblk_width) + 2;
 
-        /* Loop on resolution levels */
-        for (reslevelno = 0; reslevelno < codsty->nreslevels2decode; reslevelno++) {
-            Jpeg2000ResLevel *rlevel = comp->reslevel + reslevelno;
-            /* Loop on bands */
-            for (bandno = 0; bandno < rlevel->nbands; bandno++) {
-                int nb_precincts, precno;
-                Jpeg2000Band *band = rlevel->band + bandno;
-                int cblkno = 0, bandpos;
-
-                bandpos = bandno + (reslevelno > 0);
-
-                if (band->coord[0][0] == band->coord[0][1] ||
-                    band->coord[1][0] == band->coord[1][1])
-                    continue;
-
-                nb_precincts = rlevel->num_precincts_x * rlevel->num_precincts_y;
-                /* Loop on precincts */
-                for (precno = 0; precno < nb_precincts; precno++) {
-                    Jpeg2000Prec *prec = band->prec + precno;
-
-                    /* Loop on codeblocks */
-                    for (cblkno = 0;
-                         cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height;
-                         cblkno++) {
-                        int x, y;
-                        Jpeg2000Cblk *cblk = prec->cblk + cblkno;
-                        decode_cblk(s, codsty, &t1, cblk,
-                                    cblk->coord[0][1] - cblk->coord[0][0],
-                                    cblk->coord[1][1] - cblk->coord[1][0],
-                                    bandpos);
-
-                        x = cblk->coord[0][0] - band->coord[0][0];
-                        y = cblk->coord[1][0] - band->coord[1][0];
-
-                        if (codsty->transform == FF_DWT97)
-                            dequantization_float(x, y, cblk, comp, &t1, band);
-                        else if (codsty->transform == FF_DWT97_INT)
-                            dequantization_int_97(x, y, cblk, comp, &t1, band);
-                        else
-                            dequantization_int(x, y, cblk, comp, &t1, band);
-                   } /* end cblk */
-                } /*end prec */
-            } /* end band */
-        } /* end reslevel */
+        tile_comp_foreach_cblk(s, tile, compno, &t1, NULL);
 
         /* inverse DWT */
         ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
     } /*end comp */
 }
 
+static int jpeg2000_decode_cblk_job(AVCodecContext *avctx, void *td,
+                                    int jobnr, int threadnr)
+{
+    Jpeg2000DecoderContext *s  = avctx->priv_data;
+    const Jpeg2000CblkJob *job = s->cblk_jobs + jobnr;
+    Jpeg2000T1Context t1;
+
+    t1.stride = (1 << job->codsty->log2_cblk_width) + 2;
+    decode_dequantize_cblk(s, &t1, job);
+
+    return 0;
+}
+
+static int jpeg2000_dwt_comp_job(AVCodecContext *avctx, void *td,
+                                 int jobnr, int threadnr)
+{
+    Jpeg2000DecoderContext *s   = avctx->priv_data;
+    Jpeg2000Component *comp     = s->job_tile->comp + jobnr;
+    Jpeg2000CodingStyle *codsty = s->job_tile->codsty + jobnr;
+
+    ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
+
+    return 0;
+}
+
+/* Decode the code-blocks of all components of a tile in parallel, then
+ * run the inverse DWT of the components in parallel. Used when there are
+ * fewer tiles than threads, e.g. for single-tile digital cinema streams. */
+static int tile_codeblocks_threaded(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
+{
+    int compno, nb_jobs = 0;
+
+    for (compno = 0; compno < s->ncomponents; compno++)
+        nb_jobs += tile_comp_foreach_cblk(s, tile, compno, NULL, NULL);
+
+    av_fast_malloc(&s->cblk_jobs, &s->cblk_jobs_size,
+                   nb_jobs * sizeof(*s->cblk_jobs));
+    if (nb_jobs && !s->cblk_jobs)
+        return AVERROR(ENOMEM);
+
+    nb_jobs = 0;
+    for (compno = 0; compno < s->ncomponents; compno++)
+        nb_jobs += tile_comp_foreach_cblk(s, tile, compno, NULL,
+                                          s->cblk_jobs + nb_jobs);
+
+    s->avctx->execute2(s->avctx, jpeg2000_decode_cblk_job, NULL, NULL, nb_jobs);
+
+    s->job_tile = tile;
+    s->avctx->execute2(s->avctx, jpeg2000_dwt_comp_job, NULL, NULL, s->ncomponents);
+
+    return 0;
+}
+
 #define WRITE_FRAME(D, PIXEL)                                                                     \
     static inline void write_frame_ ## D(Jpeg2000DecoderContext * s, Jpeg2000Tile * tile,         \
                                          AVFrame * picture, int precision)                        \
@@ -1809,16 +1916,11 @@ WRITE_FRAME(16, uint16_t)
 
 #undef WRITE_FRAME
 
-static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
-                                int jobnr, int threadnr)
+static void jpeg2000_output_tile(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile,
+                                 AVFrame *picture)
 {
-    Jpeg2000DecoderContext *s = avctx->priv_data;
-    AVFrame *picture = td;
-    Jpeg2000Tile *tile = s->tile + jobnr;
     int x;
 
-    tile_codeblocks(s, tile);
-
     /* inverse MCT transformation */
     if (tile->codsty[0].mct)
         mct_decode(s, tile);
@@ -1844,6 +1946,17 @@ static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
 
         write_frame_16(s, tile, picture, precision);
     }
+}
+
+static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
+                                int jobnr, int threadnr)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+    AVFrame *picture = td;
+    Jpeg2000Tile *tile = s->tile + jobnr;
+
+    tile_codeblocks(s, tile);
+    jpeg2000_output_tile(s, tile, picture);
 
     return 0;
 }
@@ -2222,7 +2335,18 @@ static int jpeg2000_decode_frame(AVCodecContext *avctx, void *data,
     if (ret = jpeg2000_read_bitstream_packets(s))
         goto end;
 
-    avctx->execute2(avctx, jpeg2000_decode_tile, picture, NULL, s->numXtiles * s->numYtiles);
+    if ((avctx->active_thread_type & FF_THREAD_SLICE) &&
+        s->numXtiles * s->numYtiles < avctx->thread_count) {
+        int tileno;
+
+        for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++) {
+            if ((ret = tile_codeblocks_threaded(s, s->tile + tileno)) < 0)
+                goto end;
+            jpeg2000_output_tile(s, s->tile + tileno, picture);
+        }
+    } else {
+        avctx->execute2(avctx, jpeg2000_decode_tile, picture, NULL, s->numXtiles * s->numYtiles);
+    }
 
     jpeg2000_dec_cleanup(s);
 
@@ -2241,6 +2365,16 @@ end:
     return ret;
 }
 
+static av_cold int jpeg2000_decode_close(AVCodecContext *avctx)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+
+    av_freep(&s->cblk_jobs);
+    s->cblk_jobs_size = 0;
+
+    return 0;
+}
+
 #define OFFSET(x) offsetof(Jpeg2000DecoderContext, x)
 #define VD AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_DECODING_PARAM
 
@@ -2266,6 +2400,7 @@ AVCodec ff_jpeg2000_decoder = {
     .priv_data_size   = sizeof(Jpeg2000DecoderContext),
     .init             = jpeg2000_decode_init,
     .decode           = jpeg2000_decode_frame,
+    .close            = jpeg2000_decode_close,
     .priv_class       = &jpeg2000_class,
     .max_lowres       = 5,
     .profiles         = NULL_IF_CONFIG_SMALL(ff_jpeg2000_profiles)
@@ -90,11 +90,21 @@ static void rct_int(void *_src0, void *_src1, void *_src2, int csize)
     }
 }
 
+static void dwt97_lift_float(float *p, float coef, int n)
+{
+    int i, c;
+
+    for (i = 0; i < n; i++, p += 16)
+        for (c = 0; c < 8; c++)
+            p[c] += coef * (p[c - 8] + p[c + 8]);
+}
+
 av_cold void ff_jpeg2000dsp_init(Jpeg2000DSPContext *c)
 {
     c->mct_decode[FF_DWT97]     = ict_float;
     c->mct_decode[FF_DWT53]     = rct_int;
     c->mct_decode[FF_DWT97_INT] = ict_int;
+    c->dwt97_lift_float         = dwt97_lift_float;
 
     if (ARCH_X86)
         ff_jpeg2000dsp_init_x86(c);
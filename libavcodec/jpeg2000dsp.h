@@ -28,6 +28,14 @@
 
 typedef struct Jpeg2000DSPContext {
     void (*mct_decode[FF_DWT_NB])(void *src0, void *src1, void *src2, int csize);
+    /**
+     * One lifting step of the vertical 9/7 float synthesis on interleaved
+     * rows of 8 columns: for n rows starting at p and every other row after
+     * it, p[c] += coef * (p[c - 8] + p[c + 8]).
+     * @param p 16-byte aligned (32-byte for AVX)
+     * @param n number of rows to update, must be positive
+     */
+    void (*dwt97_lift_float)(float *p, float coef, int n);
 } Jpeg2000DSPContext;
 
 void ff_jpeg2000dsp_init(Jpeg2000DSPContext *c);
@@ -28,6 +28,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/common.h"
 #include "libavutil/mem.h"
+#include "jpeg2000dsp.h"
 #include "jpeg2000dwt.h"
 #include "internal.h"
 
@@ -48,6 +49,11 @@
 #define I_LFTG_X       53274ll
 #define I_PRESHIFT 8
 
+/* Number of columns the vertical 9/7 float synthesis processes at once;
+ * the lifting steps then run over contiguous rows. This is the row width
+ * Jpeg2000DSPContext.dwt97_lift_float works on. */
+#define F_VER_COLS 8
+
 static inline void extend53(int *p, int i0, int i1)
 {
     p[i0 - 1] = p[i0 + 1];
@@ -399,11 +405,45 @@ static void sr_1d97_float(float *p, int i0, int i1)
         p[2 * i + 1] += F_LFTG_ALPHA * (p[2 * i]     + p[2 * i + 2]);
 }
 
+/* Same as sr_1d97_float(), but every sample is a row of F_VER_COLS
+ * consecutive columns. */
+static void sr_1d97_float_cols(DWTContext *s, float *p, int i0, int i1)
+{
+    const int n = F_VER_COLS;
+    int i, c;
+
+    if (i1 <= i0 + 1) {
+        if (i0 == 1)
+            for (c = 0; c < n; c++)
+                p[n + c] *= F_LFTG_K/2;
+        else
+            for (c = 0; c < n; c++)
+                p[c] *= F_LFTG_X;
+        return;
+    }
+
+    for (i = 1; i <= 4; i++) {
+        memcpy(p + (i0 - i) * n,     p + (i0 + i) * n,     n * sizeof(*p));
+        memcpy(p + (i1 + i - 1) * n, p + (i1 - i - 1) * n, n * sizeof(*p));
+    }
+
+    i = (i0 >> 1) - 1;
+    s->lift97_float(p + 2 * i * n,       -F_LFTG_DELTA, (i1 >> 1) + 2 - i);
+    /* step 4 */
+    s->lift97_float(p + (2 * i + 1) * n, -F_LFTG_GAMMA, (i1 >> 1) + 1 - i);
+    /*step 5*/
+    i = i0 >> 1;
+    s->lift97_float(p + 2 * i * n,        F_LFTG_BETA,  (i1 >> 1) + 1 - i);
+    /* step 6 */
+    s->lift97_float(p + (2 * i + 1) * n,  F_LFTG_ALPHA, (i1 >> 1)     - i);
+}
+
 static void dwt_decode97_float(DWTContext *s, float *t)
 {
     int lev;
     int w       = s->linelen[s->ndeclevels - 1][0];
     float *line = s->f_linebuf;
+    float *cols = s->f_linebuf + 5 * F_VER_COLS;
     float *data = t;
     /* position at index O of line range [0-5,w+5] cf. extend function */
     line += 5;
@@ -431,20 +471,21 @@ static void dwt_decode97_float(DWTContext *s, float *t)
                 data[w * lp + i] = l[i];
         }
 
-        // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
+        // VER_SD, F_VER_COLS columns at a time
+        l = cols + mv * F_VER_COLS;
+        for (lp = 0; lp < lh; lp += F_VER_COLS) {
             int i, j = 0;
+            int n = FFMIN(F_VER_COLS, lh - lp);
             // copy with interleaving
             for (i = mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                memcpy(l + i * F_VER_COLS, data + w * j + lp, n * sizeof(*data));
             for (i = 1 - mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                memcpy(l + i * F_VER_COLS, data + w * j + lp, n * sizeof(*data));
 
-            sr_1d97_float(line, mv, mv + lv);
+            sr_1d97_float_cols(s, cols, mv, mv + lv);
 
             for (i = 0; i < lv; i++)
-                data[w * i + lp] = l[i];
+                memcpy(data + w * i + lp, l + i * F_VER_COLS, n * sizeof(*data));
         }
     }
 }
@@ -557,11 +598,17 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
                 b[i][j] = (b[i][j] + 1) >> 1;
         }
     switch (type) {
-    case FF_DWT97:
-        s->f_linebuf = av_malloc_array((maxlen + 12), sizeof(*s->f_linebuf));
+    case FF_DWT97: {
+        Jpeg2000DSPContext dsp;
+
+        s->f_linebuf = av_mallocz_array((maxlen + 12) * F_VER_COLS,
+                                        sizeof(*s->f_linebuf));
         if (!s->f_linebuf)
             return AVERROR(ENOMEM);
+        ff_jpeg2000dsp_init(&dsp);
+        s->lift97_float = dsp.dwt97_lift_float;
         break;
+    }
      case FF_DWT97_INT:
         s->i_linebuf = av_malloc_array((maxlen + 12), sizeof(*s->i_linebuf));
         if (!s->i_linebuf)
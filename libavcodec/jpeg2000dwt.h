@@ -48,6 +48,8 @@ typedef struct DWTContext {
     uint8_t type;                        ///< 0 for 9/7; 1 for 5/3
     int32_t *i_linebuf;                  ///< int buffer used by transform
     float   *f_linebuf;                  ///< float buffer used by transform
+    /// vertical 9/7 float lifting step, see Jpeg2000DSPContext.dwt97_lift_float
+    void (*lift97_float)(float *p, float coef, int n);
 } DWTContext;
 
 /**
@@ -753,10 +753,11 @@ unk_pixfmt:
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0 || code > 16) {
         av_log(s->avctx, AV_LOG_WARNING,
                "mjpeg_decode_dc: bad vlc: %d:%d (%p)\n",
@@ -765,47 +766,48 @@ static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
     }
 
     if (code)
-        return get_xbits(&s->gb, code);
+        return get_xbits(gb, code);
     else
         return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb, int *last_dc,
+                        int16_t *block, int component,
                         int dc_index, int ac_index, uint16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = val * (unsigned)quant_matrix[0] + s->last_dc[component];
+    val = val * (unsigned)quant_matrix[0] + last_dc[component];
     val = av_clip_int16(val);
-    s->last_dc[component] = val;
+    last_dc[component] = val;
     block[0] = val;
     /* AC coefs */
     i = 0;
-    {OPEN_READER(re, &s->gb);
+    {OPEN_READER(re, gb);
     do {
-        UPDATE_CACHE(re, &s->gb);
-        GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+        UPDATE_CACHE(re, gb);
+        GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
         i += ((unsigned)code) >> 4;
             code &= 0xf;
         if (code) {
             if (code > MIN_CACHE_BITS - 16)
-                UPDATE_CACHE(re, &s->gb);
+                UPDATE_CACHE(re, gb);
 
             {
-                int cache = GET_CACHE(re, &s->gb);
+                int cache = GET_CACHE(re, gb);
                 int sign  = (~cache) >> 31;
                 level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
             }
 
-            LAST_SKIP_BITS(re, &s->gb, code);
+            LAST_SKIP_BITS(re, gb, code);
 
             if (i > 63) {
                 av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -815,7 +817,7 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
             block[j] = level * quant_matrix[i];
         }
     } while (i < 63);
-    CLOSE_READER(re, &s->gb);}
+    CLOSE_READER(re, gb);}
 
     return 0;
 }
@@ -826,7 +828,7 @@ static int decode_dc_progressive(MJpegDecodeContext *s, int16_t *block,
 {
     unsigned val;
     s->bdsp.clear_block(block);
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, &s->gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
@@ -1099,7 +1101,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s, int nb_components, int p
 
                 PREDICT(pred, topleft[i], top[i], left[i], modified_predictor);
 
-                dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                 if(dc == 0xFFFFF)
                     return -1;
 
@@ -1211,7 +1213,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for(j=0; j<n; j++) {
                         int pred, dc;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1282,7 +1284,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for (j = 0; j < n; j++) {
                         int pred;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1351,17 +1353,210 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+typedef struct MJpegScanParams {
+    int nb_components;
+    int Ah, Al;
+    int chroma_width, chroma_height;
+    int bytes_per_pixel;
+    uint8_t *data[MAX_COMPONENTS];
+    const uint8_t *reference_data[MAX_COMPONENTS];
+    int linesize[MAX_COMPONENTS];
+    GetBitContext *mb_bitmask_gb;
+    /* restart interval threading */
+    const uint8_t *buf;
+    int buf_size;
+    int nb_intervals;
+} MJpegScanParams;
+
+/**
+ * Decode the MCUs [mcu_start, mcu_end) of a sequential or progressive DC
+ * scan. If restart is set, RSTn markers are handled in the bitstream,
+ * otherwise the range must not contain any.
+ */
+static int mjpeg_decode_scan_mcus(MJpegDecodeContext *s, const MJpegScanParams *p,
+                                  GetBitContext *gb, int *last_dc, int16_t *block,
+                                  int mcu_start, int mcu_end, int restart)
+{
+    int i, mcu;
+    int mb_x = mcu_start % s->mb_width;
+    int mb_y = mcu_start / s->mb_width;
+
+    for (mcu = mcu_start; mcu < mcu_end; mcu++) {
+        const int copy_mb = p->mb_bitmask_gb && !get_bits1(p->mb_bitmask_gb);
+
+        if (restart && s->restart_interval && !s->restart_count)
+            s->restart_count = s->restart_interval;
+
+        if (get_bits_left(gb) < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "overread %d\n",
+                   -get_bits_left(gb));
+            return AVERROR_INVALIDDATA;
+        }
+        for (i = 0; i < p->nb_components; i++) {
+            uint8_t *ptr;
+            int n, h, v, x, y, c, j;
+            int block_offset;
+            n = s->nb_blocks[i];
+            c = s->comp_index[i];
+            h = s->h_scount[i];
+            v = s->v_scount[i];
+            x = 0;
+            y = 0;
+            for (j = 0; j < n; j++) {
+                block_offset = (((p->linesize[c] * (v * mb_y + y) * 8) +
+                                 (h * mb_x + x) * 8 * p->bytes_per_pixel) >> s->avctx->lowres);
+
+                if (s->interlaced && s->bottom_field)
+                    block_offset += p->linesize[c] >> 1;
+                if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? p->chroma_width  : s->width)
+                    && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? p->chroma_height : s->height)) {
+                    ptr = p->data[c] + block_offset;
+                } else
+                    ptr = NULL;
+                if (!s->progressive) {
+                    if (copy_mb) {
+                        if (ptr)
+                            mjpeg_copy_block(s, ptr, p->reference_data[c] + block_offset,
+                                            p->linesize[c], s->avctx->lowres);
+
+                    } else {
+                        s->bdsp.clear_block(block);
+                        if (decode_block(s, gb, last_dc, block, i,
+                                         s->dc_index[i], s->ac_index[i],
+                                         s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                            av_log(s->avctx, AV_LOG_ERROR,
+                                   "error y=%d x=%d\n", mb_y, mb_x);
+                            return AVERROR_INVALIDDATA;
+                        }
+                        if (ptr) {
+                            s->idsp.idct_put(ptr, p->linesize[c], block);
+                            if (s->bits & 7)
+                                shift_output(s, ptr, p->linesize[c]);
+                        }
+                    }
+                } else {
+                    int block_idx  = s->block_stride[c] * (v * mb_y + y) +
+                                     (h * mb_x + x);
+                    int16_t *block = s->blocks[c][block_idx];
+                    if (p->Ah)
+                        block[0] += get_bits1(gb) *
+                                    s->quant_matrixes[s->quant_sindex[i]][0] << p->Al;
+                    else if (decode_dc_progressive(s, block, i, s->dc_index[i],
+                                                   s->quant_matrixes[s->quant_sindex[i]],
+                                                   p->Al) < 0) {
+                        av_log(s->avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return AVERROR_INVALIDDATA;
+                    }
+                }
+                ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
+                ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
+                        mb_x, mb_y, x, y, c, s->bottom_field,
+                        (v * mb_y + y) * 8, (h * mb_x + x) * 8);
+                if (++x == h) {
+                    x = 0;
+                    y++;
+                }
+            }
+        }
+
+        if (restart)
+            handle_rstn(s, p->nb_components);
+
+        if (++mb_x == s->mb_width) {
+            mb_x = 0;
+            mb_y++;
+        }
+    }
+    return 0;
+}
+
+static int mjpeg_decode_restart_interval(AVCodecContext *avctx, void *arg,
+                                         int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    const MJpegScanParams *p = arg;
+    MJpegSliceContext *sc = &s->slice_ctx[threadnr];
+    const int mcu_count = s->mb_width * s->mb_height;
+    int mcu_start = jobnr * s->restart_interval;
+    int mcu_end   = FFMIN(mcu_start + s->restart_interval, mcu_count);
+    int buf_start = jobnr ? s->rst_offsets[jobnr - 1] : 0;
+    int buf_end   = jobnr < p->nb_intervals - 1 ? s->rst_offsets[jobnr] - 2 : p->buf_size;
+    int last_dc[MAX_COMPONENTS];
+    GetBitContext gb;
+    int i, ret;
+
+    for (i = 0; i < p->nb_components; i++)
+        last_dc[i] = 4 << s->bits;
+
+    ret = init_get_bits8(&gb, p->buf + buf_start, buf_end - buf_start);
+    if (ret >= 0)
+        ret = mjpeg_decode_scan_mcus(s, p, &gb, last_dc, sc->block,
+                                     mcu_start, mcu_end, 0);
+    if (ret < 0)
+        sc->errors++;
+    return ret;
+}
+
+/**
+ * Decode the restart intervals of a sequential scan in parallel.
+ * Return AVERROR(EAGAIN) if the scan can not be split.
+ */
+static int mjpeg_decode_scan_threaded(MJpegDecodeContext *s, MJpegScanParams *p)
+{
+    AVCodecContext *avctx = s->avctx;
+    const int mcu_count = s->mb_width * s->mb_height;
+    int i, ret, pos;
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE) || avctx->thread_count <= 1 ||
+        !s->restart_interval || s->progressive || s->interlaced ||
+        p->mb_bitmask_gb || avctx->codec_id == AV_CODEC_ID_THP)
+        return AVERROR(EAGAIN);
+
+    p->nb_intervals = (mcu_count + s->restart_interval - 1) / s->restart_interval;
+    if (p->nb_intervals <= 1 || s->nb_rst_offsets < p->nb_intervals - 1)
+        return AVERROR(EAGAIN);
+
+    /* the scan data starts after the header, the markers must follow it */
+    pos = get_bits_count(&s->gb) / 8;
+    p->buf      = s->gb.buffer + pos;
+    p->buf_size = get_bits_left(&s->gb) / 8;
+    for (i = 0; i < p->nb_intervals - 1; i++) {
+        s->rst_offsets[i] -= pos;
+        if (s->rst_offsets[i] < 2 || s->rst_offsets[i] > p->buf_size ||
+            (i && s->rst_offsets[i] - 2 < s->rst_offsets[i - 1]))
+            return AVERROR(EAGAIN);
+    }
+
+    av_fast_malloc(&s->slice_ctx, &s->slice_ctx_size,
+                   avctx->thread_count * sizeof(*s->slice_ctx));
+    if (!s->slice_ctx)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < avctx->thread_count; i++)
+        s->slice_ctx[i].errors = 0;
+
+    avctx->execute2(avctx, mjpeg_decode_restart_interval, p, NULL,
+                    p->nb_intervals);
+    /* the whole scan has been consumed */
+    skip_bits_long(&s->gb, get_bits_left(&s->gb));
+
+    for (i = 0, ret = 0; i < avctx->thread_count; i++)
+        ret += s->slice_ctx[i].errors;
+    if (ret) {
+        av_log(avctx, AV_LOG_ERROR, "%d restart intervals with errors\n", ret);
+        return AVERROR_INVALIDDATA;
+    }
+    return 0;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              int mb_bitmask_size,
                              const AVFrame *reference)
 {
-    int i, mb_x, mb_y, chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
-    uint8_t *data[MAX_COMPONENTS];
-    const uint8_t *reference_data[MAX_COMPONENTS];
-    int linesize[MAX_COMPONENTS];
+    int i, ret, chroma_h_shift, chroma_v_shift;
+    MJpegScanParams p = { 0 };
     GetBitContext mb_bitmask_gb = {0}; // initialize to silence gcc warning
-    int bytes_per_pixel = 1 + (s->bits > 8);
 
     if (mb_bitmask) {
         if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
@@ -1369,107 +1564,34 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
             return AVERROR_INVALIDDATA;
         }
         init_get_bits(&mb_bitmask_gb, mb_bitmask, s->mb_width * s->mb_height);
+        p.mb_bitmask_gb = &mb_bitmask_gb;
     }
 
     s->restart_count = 0;
 
     av_pix_fmt_get_chroma_sub_sample(s->avctx->pix_fmt, &chroma_h_shift,
                                      &chroma_v_shift);
-    chroma_width  = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
-    chroma_height = AV_CEIL_RSHIFT(s->height, chroma_v_shift);
+    p.nb_components   = nb_components;
+    p.Ah              = Ah;
+    p.Al              = Al;
+    p.chroma_width    = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
+    p.chroma_height   = AV_CEIL_RSHIFT(s->height, chroma_v_shift);
+    p.bytes_per_pixel = 1 + (s->bits > 8);
 
     for (i = 0; i < nb_components; i++) {
         int c   = s->comp_index[i];
-        data[c] = s->picture_ptr->data[c];
-        reference_data[c] = reference ? reference->data[c] : NULL;
-        linesize[c] = s->linesize[c];
+        p.data[c] = s->picture_ptr->data[c];
+        p.reference_data[c] = reference ? reference->data[c] : NULL;
+        p.linesize[c] = s->linesize[c];
         s->coefs_finished[c] |= 1;
     }
 
-    for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
-        for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
-            const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
-
-            if (s->restart_interval && !s->restart_count)
-                s->restart_count = s->restart_interval;
-
-            if (get_bits_left(&s->gb) < 0) {
-                av_log(s->avctx, AV_LOG_ERROR, "overread %d\n",
-                       -get_bits_left(&s->gb));
-                return AVERROR_INVALIDDATA;
-            }
-            for (i = 0; i < nb_components; i++) {
-                uint8_t *ptr;
-                int n, h, v, x, y, c, j;
-                int block_offset;
-                n = s->nb_blocks[i];
-                c = s->comp_index[i];
-                h = s->h_scount[i];
-                v = s->v_scount[i];
-                x = 0;
-                y = 0;
-                for (j = 0; j < n; j++) {
-                    block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
-                                     (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
-
-                    if (s->interlaced && s->bottom_field)
-                        block_offset += linesize[c] >> 1;
-                    if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? chroma_width  : s->width)
-                        && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? chroma_height : s->height)) {
-                        ptr = data[c] + block_offset;
-                    } else
-                        ptr = NULL;
-                    if (!s->progressive) {
-                        if (copy_mb) {
-                            if (ptr)
-                                mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
-                                                linesize[c], s->avctx->lowres);
-
-                        } else {
-                            s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
-                                             s->dc_index[i], s->ac_index[i],
-                                             s->quant_matrixes[s->quant_sindex[i]]) < 0) {
-                                av_log(s->avctx, AV_LOG_ERROR,
-                                       "error y=%d x=%d\n", mb_y, mb_x);
-                                return AVERROR_INVALIDDATA;
-                            }
-                            if (ptr) {
-                                s->idsp.idct_put(ptr, linesize[c], s->block);
-                                if (s->bits & 7)
-                                    shift_output(s, ptr, linesize[c]);
-                            }
-                        }
-                    } else {
-                        int block_idx  = s->block_stride[c] * (v * mb_y + y) +
-                                         (h * mb_x + x);
-                        int16_t *block = s->blocks[c][block_idx];
-                        if (Ah)
-                            block[0] += get_bits1(&s->gb) *
-                                        s->quant_matrixes[s->quant_sindex[i]][0] << Al;
-                        else if (decode_dc_progressive(s, block, i, s->dc_index[i],
-                                                       s->quant_matrixes[s->quant_sindex[i]],
-                                                       Al) < 0) {
-                            av_log(s->avctx, AV_LOG_ERROR,
-                                   "error y=%d x=%d\n", mb_y, mb_x);
-                            return AVERROR_INVALIDDATA;
-                        }
-                    }
-                    ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
-                    ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
-                            mb_x, mb_y, x, y, c, s->bottom_field,
-                            (v * mb_y + y) * 8, (h * mb_x + x) * 8);
-                    if (++x == h) {
-                        x = 0;
-                        y++;
-                    }
-                }
-            }
+    ret = mjpeg_decode_scan_threaded(s, &p);
+    if (ret != AVERROR(EAGAIN))
+        return ret;
 
-            handle_rstn(s, nb_components);
-        }
-    }
-    return 0;
+    return mjpeg_decode_scan_mcus(s, &p, &s->gb, s->last_dc, s->block,
+                                  0, s->mb_width * s->mb_height, 1);
 }
 
 static int mjpeg_decode_scan_progressive_ac(MJpegDecodeContext *s, int ss,
@@ -2136,6 +2258,7 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
         return AVERROR(ENOMEM);
 
     /* unescape buffer of SOS, use special treatment for JPEG-LS */
+    s->nb_rst_offsets = 0;
     if (start_code == SOS && !s->ls) {
         const uint8_t *src = *buf_ptr;
         const uint8_t *ptr = src;
@@ -2178,6 +2301,15 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                         copy_data_segment(1);
                         if (x)
                             break;
+                    } else if (s->avctx->active_thread_type & FF_THREAD_SLICE) {
+                        /* remember where the restart intervals start */
+                        int *offsets = av_fast_realloc(s->rst_offsets, &s->rst_offsets_size,
+                                                       (s->nb_rst_offsets + 1) * sizeof(*offsets));
+                        if (!offsets)
+                            return AVERROR(ENOMEM);
+                        s->rst_offsets = offsets;
+                        s->rst_offsets[s->nb_rst_offsets++] =
+                            (dst - s->buffer) + (ptr - src);
                     }
                 }
             }
@@ -2755,6 +2887,8 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
+    av_freep(&s->rst_offsets);
+    av_freep(&s->slice_ctx);
 
     for (i = 0; i < 3; i++) {
         for (j = 0; j < 4; j++)
@@ -2805,7 +2939,7 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
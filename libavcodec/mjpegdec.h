@@ -43,6 +43,11 @@
 
 #define MAX_COMPONENTS 4
 
+typedef struct MJpegSliceContext {
+    DECLARE_ALIGNED(32, int16_t, block)[64];
+    int errors;
+} MJpegSliceContext;
+
 typedef struct MJpegDecodeContext {
     AVClass *class;
     AVCodecContext *avctx;
@@ -127,6 +132,12 @@ typedef struct MJpegDecodeContext {
     uint16_t (*ljpeg_buffer)[4];
     unsigned int ljpeg_buffer_size;
 
+    int *rst_offsets;   ///< start of each restart interval after the first in the SOS data
+    unsigned int rst_offsets_size;
+    int nb_rst_offsets;
+    MJpegSliceContext *slice_ctx; ///< one per slice thread
+    unsigned int slice_ctx_size;
+
     int extern_huff;
     AVDictionary *exif_metadata;
 
@@ -43,6 +43,8 @@ typedef struct MPEG2MetadataContext {
     int matrix_coefficients;
 
     int mpeg1_warned;
+
+    int passthrough_units;
 } MPEG2MetadataContext;
 
 
@@ -223,6 +225,11 @@ fail:
     return err;
 }
 
+static CodedBitstreamUnitType mpeg2_metadata_decompose_types[] = {
+    MPEG2_START_SEQUENCE_HEADER,
+    MPEG2_START_EXTENSION,
+};
+
 static int mpeg2_metadata_init(AVBSFContext *bsf)
 {
     MPEG2MetadataContext *ctx = bsf->priv_data;
@@ -233,6 +240,14 @@ static int mpeg2_metadata_init(AVBSFContext *bsf)
     if (err < 0)
         return err;
 
+    // Only the sequence header and extensions are modified, pictures
+    // and slices can be passed through unparsed.
+    if (ctx->passthrough_units) {
+        ctx->cbc->decompose_unit_types    = mpeg2_metadata_decompose_types;
+        ctx->cbc->nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(mpeg2_metadata_decompose_types);
+    }
+
     if (bsf->par_in->extradata) {
         err = ff_cbs_read_extradata(ctx->cbc, frag, bsf->par_in);
         if (err < 0) {
@@ -289,6 +304,11 @@ static const AVOption mpeg2_metadata_options[] = {
         OFFSET(matrix_coefficients), AV_OPT_TYPE_INT,
         { .i64 = -1 }, -1, 255, FLAGS },
 
+    { "passthrough_units", "Only parse the units which are modified, "
+        "pass all others through unchanged",
+        OFFSET(passthrough_units), AV_OPT_TYPE_BOOL,
+        { .i64 = 0 }, 0, 1, FLAGS },
+
     { NULL }
 };
 
@@ -1363,16 +1363,113 @@ static int encode_frame(AVCodecContext *c, AVFrame *frame)
     return size;
 }
 
+typedef struct BCountTrial {
+    MpegEncContext *s;
+    const AVCodec *codec;
+    int b_count;
+    int width, height;
+    int p_lambda, b_lambda, lambda2;
+    int64_t rd;
+} BCountTrial;
+
+/**
+ * Encode the downscaled pictures with t->b_count B-frames between the
+ * references and store the resulting rate-distortion cost in t->rd.
+ * The trials for different B-frame counts are independent and are run
+ * through avctx->execute().
+ */
+static int estimate_b_count_trial(AVCodecContext *avctx, void *arg)
+{
+    BCountTrial *t = arg;
+    MpegEncContext *s = t->s;
+    AVCodecContext *c;
+    AVFrame *frame;
+    int i, out_size, ret;
+    int64_t rd = 0;
+
+    c     = avcodec_alloc_context3(NULL);
+    frame = av_frame_alloc();
+    if (!c || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    c->width        = t->width;
+    c->height       = t->height;
+    c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
+    c->flags       |= s->avctx->flags & AV_CODEC_FLAG_QPEL;
+    c->mb_decision  = s->avctx->mb_decision;
+    c->me_cmp       = s->avctx->me_cmp;
+    c->mb_cmp       = s->avctx->mb_cmp;
+    c->me_sub_cmp   = s->avctx->me_sub_cmp;
+    c->pix_fmt      = AV_PIX_FMT_YUV420P;
+    c->time_base    = s->avctx->time_base;
+    c->max_b_frames = s->max_b_frames;
+    c->thread_count = 1;
+
+    ret = avcodec_open2(c, t->codec, NULL);
+    if (ret < 0)
+        goto fail;
+
+    /* the shared downscaled frames are only read; the per-trial picture
+     * type and quality are set on a private reference */
+    for (i = 0; i < s->max_b_frames + 2; i++) {
+        ret = av_frame_ref(frame, s->tmp_frames[i]);
+        if (ret < 0)
+            goto fail;
+
+        if (!i) {
+            frame->pict_type = AV_PICTURE_TYPE_I;
+            frame->quality   = 1 * FF_QP2LAMBDA;
+        } else {
+            int is_p = (i - 1) % (t->b_count + 1) == t->b_count ||
+                       i - 1 == s->max_b_frames;
+
+            frame->pict_type = is_p ? AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
+            frame->quality   = is_p ? t->p_lambda : t->b_lambda;
+        }
+
+        out_size = encode_frame(c, frame);
+        av_frame_unref(frame);
+        if (out_size < 0) {
+            ret = out_size;
+            goto fail;
+        }
+
+        if (i)
+            rd += (out_size * t->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    /* get the delayed frames */
+    out_size = encode_frame(c, NULL);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+    rd += (out_size * t->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+
+    rd += c->error[0] + c->error[1] + c->error[2];
+
+    t->rd = rd;
+    ret   = 0;
+
+fail:
+    av_frame_free(&frame);
+    avcodec_free_context(&c);
+    return ret;
+}
+
 static int estimate_best_b_count(MpegEncContext *s)
 {
     const AVCodec *codec = avcodec_find_encoder(s->avctx->codec_id);
     const int scale = s->brd_scale;
     int width  = s->width  >> scale;
     int height = s->height >> scale;
-    int i, j, out_size, p_lambda, b_lambda, lambda2;
+    int i, j, nb_trials, p_lambda, b_lambda, lambda2;
     int64_t best_rd  = INT64_MAX;
     int best_b_count = -1;
-    int ret = 0;
+    BCountTrial trials[MAX_B_FRAMES + 1];
+    int rets[MAX_B_FRAMES + 1];
 
     av_assert0(scale >= 0 && scale <= 3);
 
@@ -1418,80 +1515,35 @@ static int estimate_best_b_count(MpegEncContext *s)
                                        width >> 1, height >> 1);
         }
     }
+    emms_c();
 
-    for (j = 0; j < s->max_b_frames + 1; j++) {
-        AVCodecContext *c;
-        int64_t rd = 0;
+    for (nb_trials = 0; nb_trials < s->max_b_frames + 1; nb_trials++) {
+        BCountTrial *t = &trials[nb_trials];
 
-        if (!s->input_picture[j])
+        if (!s->input_picture[nb_trials])
             break;
 
-        c = avcodec_alloc_context3(NULL);
-        if (!c)
-            return AVERROR(ENOMEM);
-
-        c->width        = width;
-        c->height       = height;
-        c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
-        c->flags       |= s->avctx->flags & AV_CODEC_FLAG_QPEL;
-        c->mb_decision  = s->avctx->mb_decision;
-        c->me_cmp       = s->avctx->me_cmp;
-        c->mb_cmp       = s->avctx->mb_cmp;
-        c->me_sub_cmp   = s->avctx->me_sub_cmp;
-        c->pix_fmt      = AV_PIX_FMT_YUV420P;
-        c->time_base    = s->avctx->time_base;
-        c->max_b_frames = s->max_b_frames;
-
-        ret = avcodec_open2(c, codec, NULL);
-        if (ret < 0)
-            goto fail;
-
-        s->tmp_frames[0]->pict_type = AV_PICTURE_TYPE_I;
-        s->tmp_frames[0]->quality   = 1 * FF_QP2LAMBDA;
-
-        out_size = encode_frame(c, s->tmp_frames[0]);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-
-        //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
-
-        for (i = 0; i < s->max_b_frames + 1; i++) {
-            int is_p = i % (j + 1) == j || i == s->max_b_frames;
-
-            s->tmp_frames[i + 1]->pict_type = is_p ?
-                                     AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
-            s->tmp_frames[i + 1]->quality   = is_p ? p_lambda : b_lambda;
-
-            out_size = encode_frame(c, s->tmp_frames[i + 1]);
-            if (out_size < 0) {
-                ret = out_size;
-                goto fail;
-            }
-
-            rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
-
-        /* get the delayed frames */
-        out_size = encode_frame(c, NULL);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-        rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
-
-        rd += c->error[0] + c->error[1] + c->error[2];
-
-        if (rd < best_rd) {
-            best_rd = rd;
+        t->s        = s;
+        t->codec    = codec;
+        t->b_count  = nb_trials;
+        t->width    = width;
+        t->height   = height;
+        t->p_lambda = p_lambda;
+        t->b_lambda = b_lambda;
+        t->lambda2  = lambda2;
+        t->rd       = INT64_MAX;
+    }
+
+    s->avctx->execute(s->avctx, estimate_b_count_trial, trials, rets,
+                      nb_trials, sizeof(*trials));
+
+    for (j = 0; j < nb_trials; j++) {
+        if (rets[j] < 0)
+            return rets[j];
+        if (trials[j].rd < best_rd) {
+            best_rd = trials[j].rd;
             best_b_count = j;
         }
-
-fail:
-        avcodec_free_context(&c);
-        if (ret < 0)
-            return ret;
     }
 
     return best_b_count;
@@ -379,38 +379,65 @@ static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
     return 0;
 }
 
+/* Runs one trial on a per-thread copy of the frame, leaving the real one intact */
+static int bands_dist_trial(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    OpusPsyContext *s = arg;
+    OpusPsyTrial *t = &s->trials[jobnr];
+    CeltFrame *f = &s->trial_frame[threadnr];
+
+    memcpy(f, s->trial_src, sizeof(*f));
+    f->pvq              = s->trial_pvq[threadnr];
+    f->intensity_stereo = t->intensity_stereo;
+    f->dual_stereo      = t->dual_stereo;
+
+    return bands_dist(s, f, &t->dist);
+}
+
+static void run_trials(OpusPsyContext *s, const CeltFrame *f, int nb_trials)
+{
+    s->trial_src = f;
+    s->avctx->execute2(s->avctx, bands_dist_trial, s, NULL, nb_trials);
+}
+
 static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
 {
-    float td1, td2;
     f->dual_stereo = 0;
 
     if (s->avctx->channels < 2)
         return;
 
-    bands_dist(s, f, &td1);
-    f->dual_stereo = 1;
-    bands_dist(s, f, &td2);
+    s->trials[0].intensity_stereo = s->trials[1].intensity_stereo = f->intensity_stereo;
+    s->trials[0].dual_stereo = 0;
+    s->trials[1].dual_stereo = 1;
+    run_trials(s, f, 2);
 
-    f->dual_stereo = td2 < td1;
-    s->dual_stereo_used += td2 < td1;
+    f->dual_stereo = s->trials[1].dist < s->trials[0].dist;
+    s->dual_stereo_used += f->dual_stereo;
 }
 
 static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
 {
-    int i, best_band = CELT_MAX_BANDS - 1;
-    float dist, best_dist = FLT_MAX;
+    int i, nb_trials = 0, best_band = CELT_MAX_BANDS - 1;
+    float best_dist = FLT_MAX;
     /* TODO: fix, make some heuristic up here using the lambda value */
     float end_band = 0;
 
     if (s->avctx->channels < 2)
         return;
 
+    /* All candidate bands are independent of each other, try them in parallel */
     for (i = f->end_band; i >= end_band; i--) {
-        f->intensity_stereo = i;
-        bands_dist(s, f, &dist);
-        if (best_dist > dist) {
-            best_dist = dist;
-            best_band = i;
+        s->trials[nb_trials].intensity_stereo = i;
+        s->trials[nb_trials].dual_stereo      = f->dual_stereo;
+        nb_trials++;
+    }
+    run_trials(s, f, nb_trials);
+
+    for (i = 0; i < nb_trials; i++) {
+        if (best_dist > s->trials[i].dist) {
+            best_dist = s->trials[i].dist;
+            best_band = s->trials[i].intensity_stereo;
         }
     }
 
@@ -540,6 +567,17 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
         goto fail;
     }
 
+    s->nb_trial_ctx = FFMAX(avctx->thread_count, 1);
+    s->trial_frame  = av_malloc_array(s->nb_trial_ctx, sizeof(*s->trial_frame));
+    s->trial_pvq    = av_mallocz_array(s->nb_trial_ctx, sizeof(*s->trial_pvq));
+    if (!s->trial_frame || !s->trial_pvq) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (i = 0; i < s->nb_trial_ctx; i++)
+        if ((ret = ff_celt_pvq_init(&s->trial_pvq[i], 1)) < 0)
+            goto fail;
+
     for (ch = 0; ch < s->avctx->channels; ch++) {
         for (i = 0; i < CELT_MAX_BANDS; i++) {
             bessel_init(&s->bfilter_hi[ch][i], 1.0f, 19.0f, 100.0f, 1);
@@ -574,6 +612,11 @@ fail:
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    for (i = 0; s->trial_pvq && i < s->nb_trial_ctx; i++)
+        ff_celt_pvq_uninit(&s->trial_pvq[i]);
+    av_freep(&s->trial_pvq);
+    av_freep(&s->trial_frame);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
@@ -597,6 +640,11 @@ av_cold int ff_opus_psy_end(OpusPsyContext *s)
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    for (i = 0; s->trial_pvq && i < s->nb_trial_ctx; i++)
+        ff_celt_pvq_uninit(&s->trial_pvq[i]);
+    av_freep(&s->trial_pvq);
+    av_freep(&s->trial_frame);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
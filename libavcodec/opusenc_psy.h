@@ -51,6 +51,13 @@ typedef struct PsyChain {
     int end;
 } PsyChain;
 
+/* A single dry-run of the band quantization with a given stereo config */
+typedef struct OpusPsyTrial {
+    int   intensity_stereo;
+    int   dual_stereo;
+    float dist;
+} OpusPsyTrial;
+
 typedef struct OpusPsyContext {
     AVCodecContext *avctx;
     AVFloatDSPContext *dsp;
@@ -73,6 +80,13 @@ typedef struct OpusPsyContext {
 
     DECLARE_ALIGNED(32, float, scratch)[2048];
 
+    /* Stereo trial search, run through execute2(), scratch is per thread */
+    OpusPsyTrial trials[CELT_MAX_BANDS + 1];
+    const CeltFrame *trial_src;
+    CeltFrame *trial_frame;
+    CeltPVQ **trial_pvq;
+    int nb_trial_ctx;
+
     /* Stats */
     float rc_waste;
     float avg_is_band;
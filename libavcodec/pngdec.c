@@ -219,6 +219,14 @@ void ff_add_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top,
             b = dst[2];                                                       \
         if (bpp >= 4)                                                         \
             a = dst[3];                                                       \
+        if (bpp >= 6) {                                                       \
+            c4 = dst[4];                                                      \
+            c5 = dst[5];                                                      \
+        }                                                                     \
+        if (bpp >= 8) {                                                       \
+            c6 = dst[6];                                                      \
+            c7 = dst[7];                                                      \
+        }                                                                     \
         for (; i <= size - bpp; i += bpp) {                                   \
             dst[i + 0] = r = op(r, src[i + 0], last[i + 0]);                  \
             if (bpp == 1)                                                     \
@@ -230,6 +238,14 @@ void ff_add_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top,
             if (bpp == 3)                                                     \
                 continue;                                                     \
             dst[i + 3] = a = op(a, src[i + 3], last[i + 3]);                  \
+            if (bpp == 4)                                                     \
+                continue;                                                     \
+            dst[i + 4] = c4 = op(c4, src[i + 4], last[i + 4]);                \
+            dst[i + 5] = c5 = op(c5, src[i + 5], last[i + 5]);                \
+            if (bpp == 6)                                                     \
+                continue;                                                     \
+            dst[i + 6] = c6 = op(c6, src[i + 6], last[i + 6]);                \
+            dst[i + 7] = c7 = op(c7, src[i + 7], last[i + 7]);                \
         }                                                                     \
     }
 
@@ -242,6 +258,10 @@ void ff_add_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top,
         UNROLL1(3, op)                                                        \
     } else if (bpp == 4) {                                                    \
         UNROLL1(4, op)                                                        \
+    } else if (bpp == 6) {                                                    \
+        UNROLL1(6, op)                                                        \
+    } else if (bpp == 8) {                                                    \
+        UNROLL1(8, op)                                                        \
     }                                                                         \
     for (; i < size; i++) {                                                   \
         dst[i] = op(dst[i - bpp], src[i], last[i]);                           \
@@ -251,7 +271,7 @@ void ff_add_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top,
 static void png_filter_row(PNGDSPContext *dsp, uint8_t *dst, int filter_type,
                            uint8_t *src, uint8_t *last, int size, int bpp)
 {
-    int i, p, r, g, b, a;
+    int i, p, r, g, b, a, c4, c5, c6, c7;
 
     switch (filter_type) {
     case PNG_FILTER_VALUE_NONE:
@@ -267,6 +287,16 @@ static void png_filter_row(PNGDSPContext *dsp, uint8_t *dst, int filter_type,
                 p = ((s & 0x7f7f7f7f) + (p & 0x7f7f7f7f)) ^ ((s ^ p) & 0x80808080);
                 *(int *)(dst + i) = p;
             }
+        } else if (bpp == 8) {
+            /* same byte-wise SWAR addition, two words per 16-bit RGBA pixel */
+            unsigned p0 = AV_RN32(dst), p1 = AV_RN32(dst + 4);
+            for (; i < size; i += bpp) {
+                unsigned s0 = AV_RN32(src + i), s1 = AV_RN32(src + i + 4);
+                p0 = ((s0 & 0x7f7f7f7f) + (p0 & 0x7f7f7f7f)) ^ ((s0 ^ p0) & 0x80808080);
+                p1 = ((s1 & 0x7f7f7f7f) + (p1 & 0x7f7f7f7f)) ^ ((s1 ^ p1) & 0x80808080);
+                AV_WN32(dst + i,     p0);
+                AV_WN32(dst + i + 4, p1);
+            }
         } else {
 #define OP_SUB(x, s, l) ((x) + (s))
             UNROLL_FILTER(OP_SUB);
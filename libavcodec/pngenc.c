@@ -45,6 +45,21 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+typedef struct PNGEncSlice {
+    z_stream zstream;            ///< raw deflate stream, no zlib header/trailer
+    int zstream_inited;
+    uint8_t *crow_base;
+    unsigned int crow_base_size;
+    uint8_t *out;
+    unsigned int out_size;
+    int out_len;
+    uLong adler;                 ///< adler32 of the uncompressed filtered rows
+    int y_start, y_end;
+    int row_size;
+    int last;
+    const AVFrame *frame;
+} PNGEncSlice;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -57,6 +72,11 @@ typedef struct PNGEncContext {
 
     z_stream zstream;
     uint8_t buf[IOBUF_SIZE];
+    int compression_level;
+
+    PNGEncSlice *slices;         ///< independently compressed IDAT segments
+    int *slice_rets;             ///< return values of the slice jobs
+    int nb_slices;
     int dpi;                     ///< Physical pixel density, in dots per inch, if set
     int dpm;                     ///< Physical pixel density, in dots per meter, if set
 
@@ -428,6 +448,151 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int png_encode_slice(AVCodecContext *avctx, void *arg)
+{
+    PNGEncContext *s   = avctx->priv_data;
+    PNGEncSlice *sl    = arg;
+    const AVFrame *p   = sl->frame;
+    z_stream *zstream  = &sl->zstream;
+    int hdr_len        = sl->y_start ? 0 : 2;
+    uint8_t *ptr, *top, *crow;
+    uint8_t *crow_buf  = sl->crow_base + 15;
+    uLong adler        = adler32(0L, Z_NULL, 0);
+    int y, ret;
+
+    top = sl->y_start ? p->data[0] + (sl->y_start - 1) * p->linesize[0] : NULL;
+
+    zstream->next_out  = sl->out + hdr_len;
+    zstream->avail_out = sl->out_size - hdr_len - 4;
+    for (y = sl->y_start; y < sl->y_end; y++) {
+        ptr  = p->data[0] + y * p->linesize[0];
+        crow = png_choose_filter(s, crow_buf, ptr, top,
+                                 sl->row_size, s->bits_per_pixel >> 3);
+        adler = adler32(adler, crow, sl->row_size + 1);
+        zstream->next_in  = crow;
+        zstream->avail_in = sl->row_size + 1;
+        while (zstream->avail_in > 0) {
+            if (deflate(zstream, Z_NO_FLUSH) != Z_OK || !zstream->avail_out) {
+                ret = AVERROR_EXTERNAL;
+                goto the_end;
+            }
+        }
+        top = ptr;
+    }
+
+    /* A sync flush ends the segment on a byte boundary with a non-final
+     * block, so the next segment's output can simply be appended. */
+    ret = deflate(zstream, sl->last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret != (sl->last ? Z_STREAM_END : Z_OK) || !zstream->avail_out) {
+        ret = AVERROR_EXTERNAL;
+        goto the_end;
+    }
+
+    sl->out_len = zstream->next_out - sl->out;
+    sl->adler   = adler;
+    ret = 0;
+
+the_end:
+    deflateReset(zstream);
+    return ret;
+}
+
+/**
+ * Compress the image as several independent deflate segments, one per
+ * slice, which are joined into a single zlib stream and written as one
+ * IDAT chunk each. Only the zlib header, the combined adler32 and the
+ * segment boundaries differ from the single stream output.
+ */
+static int encode_frame_slices(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int nb_slices    = FFMIN(s->nb_slices, pict->height);
+    int row_size     = (pict->width * s->bits_per_pixel + 7) >> 3;
+    int i, ret, header, level_flags;
+    uLong adler;
+    PNGEncSlice *sl;
+
+    for (i = 0; i < nb_slices; i++) {
+        uLong in_len;
+
+        sl = &s->slices[i];
+        sl->y_start  = pict->height *  i      / nb_slices;
+        sl->y_end    = pict->height * (i + 1) / nb_slices;
+        sl->row_size = row_size;
+        sl->last     = i == nb_slices - 1;
+        sl->frame    = pict;
+
+        av_fast_malloc(&sl->crow_base, &sl->crow_base_size,
+                       (row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+        if (!sl->crow_base) {
+            ret = AVERROR(ENOMEM);
+            goto the_end;
+        }
+
+        /* room for the zlib header, the flush marker and the adler32 */
+        in_len = (uLong)(sl->y_end - sl->y_start) * (row_size + 1);
+        av_fast_malloc(&sl->out, &sl->out_size,
+                       deflateBound(&sl->zstream, in_len) + 2 + 16 + 4);
+        if (!sl->out) {
+            ret = AVERROR(ENOMEM);
+            goto the_end;
+        }
+    }
+
+    avctx->execute(avctx, png_encode_slice, s->slices, s->slice_rets,
+                   nb_slices, sizeof(*s->slices));
+    for (i = 0; i < nb_slices; i++) {
+        if (s->slice_rets[i] < 0) {
+            ret = s->slice_rets[i];
+            goto the_end;
+        }
+    }
+
+    /* zlib header for a 32K window, matching what deflate() would write */
+    if (s->compression_level >= 0 && s->compression_level < 2)
+        level_flags = 0;
+    else if (s->compression_level >= 0 && s->compression_level < 6)
+        level_flags = 1;
+    else if (s->compression_level < 0 || s->compression_level == 6)
+        level_flags = 2;
+    else
+        level_flags = 3;
+    header  = (Z_DEFLATED + (7 << 4)) << 8 | level_flags << 6;
+    header += 31 - header % 31;
+    AV_WB16(s->slices[0].out, header);
+
+    adler = s->slices[0].adler;
+    for (i = 0; i < nb_slices; i++) {
+        sl = &s->slices[i];
+        if (!sl->out_len) {
+            ret = AVERROR_BUG;
+            goto the_end;
+        }
+        if (i)
+            adler = adler32_combine(adler, sl->adler,
+                                    (z_off_t)(sl->y_end - sl->y_start) * (row_size + 1));
+    }
+    sl = &s->slices[nb_slices - 1];
+    AV_WB32(sl->out + sl->out_len, adler);
+    sl->out_len += 4;
+
+    for (i = 0; i < nb_slices; i++) {
+        sl = &s->slices[i];
+        if (s->bytestream_end - s->bytestream < sl->out_len + 12) {
+            ret = AVERROR_BUG;
+            goto the_end;
+        }
+        png_write_image_data(avctx, sl->out, sl->out_len);
+    }
+    ret = 0;
+
+the_end:
+    /* a failed slice must not find stale data on the next frame */
+    for (i = 0; i < nb_slices; i++)
+        s->slices[i].out_len = 0;
+    return ret;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -439,6 +604,9 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
     uint8_t *progressive_buf = NULL;
     uint8_t *top_buf         = NULL;
 
+    if (s->nb_slices > 1)
+        return encode_frame_slices(avctx, pict);
+
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
@@ -535,7 +703,9 @@ static int encode_png(AVCodecContext *avctx, AVPacket *pkt,
         avctx->height * (
             enc_row_size +
             12 * (((int64_t)enc_row_size + IOBUF_SIZE - 1) / IOBUF_SIZE) // IDAT * ceil(enc_row_size / IOBUF_SIZE)
-        );
+        ) +
+        s->nb_slices * (2 + 16 + 4 + 12); // per-segment flush marker, zlib header/trailer and IDAT
+
     if (max_packet_size > INT_MAX)
         return AVERROR(ENOMEM);
     ret = ff_alloc_packet2(avctx, pkt, max_packet_size, 0);
@@ -1091,6 +1261,28 @@ FF_ENABLE_DEPRECATION_WARNINGS
                       : av_clip(avctx->compression_level, 0, 9);
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
+    s->compression_level = compression_level;
+
+    if (avctx->codec_id == AV_CODEC_ID_PNG && avctx->slices > 1 &&
+        !s->is_progressive) {
+        int i;
+
+        s->slices     = av_mallocz_array(avctx->slices, sizeof(*s->slices));
+        s->slice_rets = av_mallocz_array(avctx->slices, sizeof(*s->slice_rets));
+        if (!s->slices || !s->slice_rets)
+            return AVERROR(ENOMEM);
+        s->nb_slices = avctx->slices;
+        for (i = 0; i < s->nb_slices; i++) {
+            PNGEncSlice *sl = &s->slices[i];
+            sl->zstream.zalloc = ff_png_zalloc;
+            sl->zstream.zfree  = ff_png_zfree;
+            sl->zstream.opaque = NULL;
+            if (deflateInit2(&sl->zstream, compression_level, Z_DEFLATED,
+                             -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return -1;
+            sl->zstream_inited = 1;
+        }
+    }
 
     return 0;
 }
@@ -1100,6 +1292,18 @@ static av_cold int png_enc_close(AVCodecContext *avctx)
     PNGEncContext *s = avctx->priv_data;
 
     deflateEnd(&s->zstream);
+    if (s->slices) {
+        int i;
+        for (i = 0; i < s->nb_slices; i++) {
+            if (s->slices[i].zstream_inited)
+                deflateEnd(&s->slices[i].zstream);
+            av_freep(&s->slices[i].crow_base);
+            av_freep(&s->slices[i].out);
+        }
+        av_freep(&s->slices);
+    }
+    av_freep(&s->slice_rets);
+    s->nb_slices = 0;
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1146,7 +1350,9 @@ AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_INTRA_ONLY,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS |
+                      AV_CODEC_CAP_INTRA_ONLY,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
@@ -31,11 +31,17 @@ cextern pb_80
 SECTION .text
 
 %macro DIFF_PIXELS_1 4
+%if mmsize == 32
+    pmovzxbw        %1, %3
+    pmovzxbw        %2, %4
+    psubw           %1, %2
+%else
     movh            %1, %3
     movh            %2, %4
     punpcklbw       %2, %1
     punpcklbw       %1, %1
     psubw           %1, %2
+%endif
 %endmacro
 
 ; %1=uint8_t *pix1, %2=uint8_t *pix2, %3=static offset, %4=stride, %5=stride*3
@@ -279,6 +285,43 @@ INIT_XMM ssse3
 %define ABS_SUM_8x8 ABS_SUM_8x8_64
 HADAMARD8_DIFF 9
 
+%if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+INIT_YMM avx2
+; two horizontally adjacent 8x8 blocks, the left one in the low lane and the
+; right one in the high lane; each block sum saturates separately, like the
+; 8x8 versions above
+hadamard16x8_diff %+ SUFFIX:
+    lea                          r0, [r3*3]
+    DIFF_PIXELS_8                r1, r2,  0, r3, r0, 0
+    HADAMARD8
+    TRANSPOSE8x8W                 0,  1,  2,  3,  4,  5,  6,  7,  8
+    HADAMARD8
+    ABS_SUM_8x8_64                0
+    vextracti128                xm1, m0, 1
+    HSUM                        xm0, xm2, eax
+    HSUM                        xm1, xm2, r0d
+    and                         eax, 0xFFFF
+    and                         r0d, 0xFFFF
+    add                         eax, r0d
+    ret
+
+cglobal hadamard8_diff16, 5, 6, 10
+    call hadamard16x8_diff %+ SUFFIX
+    mov            r5d, eax
+
+    cmp            r4d, 16
+    jne .done
+
+    lea             r1, [r1+r3*8]
+    lea             r2, [r2+r3*8]
+    call hadamard16x8_diff %+ SUFFIX
+    add            r5d, eax
+
+.done:
+    mov            eax, r5d
+    RET
+%endif
+
 ; int ff_sse*_*(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
 ;               ptrdiff_t line_size, int h)
 
@@ -672,6 +715,126 @@ SAD_Y2 16
 INIT_XMM sse2
 SAD_Y2 16
 
+%if HAVE_AVX2_EXTERNAL
+;------------------------------------------------------------------------------------------
+;int ff_sad{8,16}{,_x2,_y2}_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2, ptrdiff_t stride, int h);
+;------------------------------------------------------------------------------------------
+; two rows per register, row n in the low lane and row n+1 in the high lane
+%macro LOAD_2ROWS 3 ; dst, row n, row n+1
+    movu         xm%1, %2
+    vinserti128   m%1, m%1, %3, 1
+%endmacro
+
+; four 8-pixel rows per register, one per qword
+%macro LOAD_4ROWS 6 ; dst, tmp, row n, row n+1, row n+2, row n+3
+    movq         xm%1, %3
+    movhps       xm%1, %4
+    movq         xm%2, %5
+    movhps       xm%2, %6
+    vinserti128   m%1, m%1, xm%2, 1
+%endmacro
+
+%macro SAD_AVX2_END 0
+    vextracti128  xm0, m2, 1
+    paddw         xm2, xm0
+    movhlps       xm0, xm2
+    paddw         xm2, xm0
+    movd          eax, xm2
+    RET
+%endmacro
+
+INIT_YMM avx2
+cglobal sad16, 5, 5, 3, v, pix1, pix2, stride, h
+    pxor           m2, m2
+.loop:
+    LOAD_2ROWS      0, [pix2q], [pix2q+strideq]
+    LOAD_2ROWS      1, [pix1q], [pix1q+strideq]
+    psadbw         m0, m1
+    paddw          m2, m0
+    lea         pix1q, [pix1q+2*strideq]
+    lea         pix2q, [pix2q+2*strideq]
+    sub            hd, 2
+    jg .loop
+    SAD_AVX2_END
+
+cglobal sad16_x2, 5, 5, 4, v, pix1, pix2, stride, h
+    pxor           m2, m2
+.loop:
+    LOAD_2ROWS      0, [pix2q], [pix2q+strideq]
+    LOAD_2ROWS      3, [pix2q+1], [pix2q+strideq+1]
+    LOAD_2ROWS      1, [pix1q], [pix1q+strideq]
+    pavgb          m0, m3
+    psadbw         m0, m1
+    paddw          m2, m0
+    lea         pix1q, [pix1q+2*strideq]
+    lea         pix2q, [pix2q+2*strideq]
+    sub            hd, 2
+    jg .loop
+    SAD_AVX2_END
+
+cglobal sad16_y2, 5, 5, 4, v, pix1, pix2, stride, h
+    pxor           m2, m2
+.loop:
+    LOAD_2ROWS      0, [pix2q], [pix2q+strideq]
+    LOAD_2ROWS      3, [pix2q+strideq], [pix2q+2*strideq]
+    LOAD_2ROWS      1, [pix1q], [pix1q+strideq]
+    pavgb          m0, m3
+    psadbw         m0, m1
+    paddw          m2, m0
+    lea         pix1q, [pix1q+2*strideq]
+    lea         pix2q, [pix2q+2*strideq]
+    sub            hd, 2
+    jg .loop
+    SAD_AVX2_END
+
+; h is a multiple of 4
+cglobal sad8, 5, 6, 4, v, pix1, pix2, stride, h, stride3
+    lea       stride3q, [strideq*3]
+    pxor           m2, m2
+.loop:
+    LOAD_4ROWS      0, 3, [pix2q], [pix2q+strideq], [pix2q+2*strideq], [pix2q+stride3q]
+    LOAD_4ROWS      1, 3, [pix1q], [pix1q+strideq], [pix1q+2*strideq], [pix1q+stride3q]
+    psadbw         m0, m1
+    paddw          m2, m0
+    lea         pix1q, [pix1q+4*strideq]
+    lea         pix2q, [pix2q+4*strideq]
+    sub            hd, 4
+    jg .loop
+    SAD_AVX2_END
+
+cglobal sad8_x2, 5, 6, 5, v, pix1, pix2, stride, h, stride3
+    lea       stride3q, [strideq*3]
+    pxor           m2, m2
+.loop:
+    LOAD_4ROWS      0, 3, [pix2q], [pix2q+strideq], [pix2q+2*strideq], [pix2q+stride3q]
+    LOAD_4ROWS      4, 3, [pix2q+1], [pix2q+strideq+1], [pix2q+2*strideq+1], [pix2q+stride3q+1]
+    LOAD_4ROWS      1, 3, [pix1q], [pix1q+strideq], [pix1q+2*strideq], [pix1q+stride3q]
+    pavgb          m0, m4
+    psadbw         m0, m1
+    paddw          m2, m0
+    lea         pix1q, [pix1q+4*strideq]
+    lea         pix2q, [pix2q+4*strideq]
+    sub            hd, 4
+    jg .loop
+    SAD_AVX2_END
+
+cglobal sad8_y2, 5, 6, 5, v, pix1, pix2, stride, h, stride3
+    lea       stride3q, [strideq*3]
+    pxor           m2, m2
+.loop:
+    LOAD_4ROWS      0, 3, [pix2q], [pix2q+strideq], [pix2q+2*strideq], [pix2q+stride3q]
+    LOAD_4ROWS      4, 3, [pix2q+strideq], [pix2q+2*strideq], [pix2q+stride3q], [pix2q+4*strideq]
+    LOAD_4ROWS      1, 3, [pix1q], [pix1q+strideq], [pix1q+2*strideq], [pix1q+stride3q]
+    pavgb          m0, m4
+    psadbw         m0, m1
+    paddw          m2, m0
+    lea         pix1q, [pix1q+4*strideq]
+    lea         pix2q, [pix2q+4*strideq]
+    sub            hd, 4
+    jg .loop
+    SAD_AVX2_END
+%endif
+
 ;-------------------------------------------------------------------------------------------
 ;int ff_sad_approx_xy2_<opt>(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2, ptrdiff_t stride, int h);
 ;-------------------------------------------------------------------------------------------
@@ -47,18 +47,30 @@ int ff_sad16_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                     ptrdiff_t stride, int h);
 int ff_sad16_sse2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                   ptrdiff_t stride, int h);
+int ff_sad16_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                  ptrdiff_t stride, int h);
+int ff_sad8_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                 ptrdiff_t stride, int h);
 int ff_sad8_x2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                       ptrdiff_t stride, int h);
 int ff_sad16_x2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                        ptrdiff_t stride, int h);
 int ff_sad16_x2_sse2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                      ptrdiff_t stride, int h);
+int ff_sad16_x2_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                     ptrdiff_t stride, int h);
+int ff_sad8_x2_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                    ptrdiff_t stride, int h);
 int ff_sad8_y2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                       ptrdiff_t stride, int h);
 int ff_sad16_y2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                        ptrdiff_t stride, int h);
 int ff_sad16_y2_sse2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                      ptrdiff_t stride, int h);
+int ff_sad16_y2_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                     ptrdiff_t stride, int h);
+int ff_sad8_y2_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                    ptrdiff_t stride, int h);
 int ff_sad8_approx_xy2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                               ptrdiff_t stride, int h);
 int ff_sad16_approx_xy2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
@@ -88,6 +100,8 @@ hadamard_func(mmx)
 hadamard_func(mmxext)
 hadamard_func(sse2)
 hadamard_func(ssse3)
+int ff_hadamard8_diff16_avx2(MpegEncContext *s, uint8_t *src1, uint8_t *src2,
+                             ptrdiff_t stride, int h);
 
 #if HAVE_X86ASM
 static int nsse16_mmx(MpegEncContext *c, uint8_t *pix1, uint8_t *pix2,
@@ -646,6 +660,22 @@ av_cold void ff_me_cmp_init_x86(MECmpContext *c, AVCodecContext *avctx)
 #if HAVE_ALIGNED_STACK
         c->hadamard8_diff[0] = ff_hadamard8_diff16_ssse3;
         c->hadamard8_diff[1] = ff_hadamard8_diff_ssse3;
+#endif
+    }
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        c->sad[0]        = ff_sad16_avx2;
+        c->pix_abs[0][0] = ff_sad16_avx2;
+        c->pix_abs[0][1] = ff_sad16_x2_avx2;
+        c->pix_abs[0][2] = ff_sad16_y2_avx2;
+        c->sad[1]        = ff_sad8_avx2;
+        c->pix_abs[1][0] = ff_sad8_avx2;
+        c->pix_abs[1][1] = ff_sad8_x2_avx2;
+        c->pix_abs[1][2] = ff_sad8_y2_avx2;
+#if ARCH_X86_64
+        /* 8x8 blocks only fill one lane, so the ssse3 version is kept
+         * for hadamard8_diff[1]. */
+        c->hadamard8_diff[0] = ff_hadamard8_diff16_avx2;
 #endif
     }
 }
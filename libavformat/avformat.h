@@ -1944,6 +1944,16 @@ typedef struct AVFormatContext {
      * - decoding: set by user
      */
     int skip_estimate_duration_from_pts;
+
+    /**
+     * Number of threads used to run the trial decodes of
+     * avformat_find_stream_info(). Decodes of different streams run in
+     * parallel, decodes of the same stream stay in packet order.
+     * 1 probes serially, 0 picks a thread count automatically.
+     * - encoding: unused
+     * - decoding: set by user
+     */
+    int stream_info_threads;
 } AVFormatContext;
 
 #if FF_API_FORMAT_GET_SET
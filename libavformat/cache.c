@@ -23,16 +23,19 @@
 
 /**
  * @TODO
- *      support keeping files
  *      support filling with a background thread
  */
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/hash.h"
 #include "libavutil/internal.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
 #include "libavutil/tree.h"
 #include "avformat.h"
+#include "internal.h"
 #include <fcntl.h>
 #if HAVE_IO_H
 #include <io.h>
@@ -45,15 +48,27 @@
 #include "os_support.h"
 #include "url.h"
 
+#define INDEX_MAGIC       MKTAG('F', 'F', 'C', 'I')
+#define INDEX_VERSION     1
+#define INDEX_HEADER_SIZE 20
+#define INDEX_ENTRY_SIZE  20
+
 typedef struct CacheEntry {
     int64_t logical_pos;
     int64_t physical_pos;
     int size;
+    int shared;     ///< data is in the shared cache file, not in fd
 } CacheEntry;
 
 typedef struct Context {
     AVClass *class;
     int fd;
+    int shared_fd;
+    int locked;     ///< holds a lock on the persistent cache of this resource
+    int writer;     ///< owns the persistent cache file of this resource
+    char *cache_dir;
+    int64_t cache_max_size;
+    char *path;     ///< cache file path without extension
     struct AVTreeNode *root;
     int64_t logical_pos;
     int64_t cache_pos;
@@ -70,24 +85,485 @@ static int cmp(const void *key, const void *node)
     return FFDIFFSIGN(*(const int64_t *)key, ((const CacheEntry *) node)->logical_pos);
 }
 
+static int enu_free(void *opaque, void *elem)
+{
+    av_free(elem);
+    return 0;
+}
+
+#if HAVE_FCNTL
+/* Each resource has a lock file. Every context using the resource holds a
+ * shared lock on its byte 1, the context adding to the cache also holds an
+ * exclusive lock on its byte 0, and eviction takes an exclusive lock on
+ * byte 1.
+ * fcntl() locks do not exclude other contexts of the same process, and are
+ * dropped when any descriptor of the file is closed, so the lock files used
+ * by this process are tracked here, with one descriptor each. */
+typedef struct LockedPath {
+    char *path;
+    int fd;
+    int users;
+    int writer;
+} LockedPath;
+
+static AVMutex locked_mutex = AV_MUTEX_INITIALIZER;
+static LockedPath *locked_paths;
+static int nb_locked_paths;
+
+static int lock_range(int fd, int type, int start)
+{
+    struct flock fl = { .l_type = type, .l_whence = SEEK_SET,
+                        .l_start = start, .l_len = 1 };
+    return fcntl(fd, F_SETLK, &fl);
+}
+
+/* Return true if fd still refers to the file at path, i.e. the file has not
+ * been evicted since it was opened. */
+static int same_file(int fd, const char *path)
+{
+    struct stat st_fd, st_path;
+
+    return !fstat(fd, &st_fd) && !stat(path, &st_path) &&
+           st_fd.st_dev == st_path.st_dev && st_fd.st_ino == st_path.st_ino;
+}
+
+/* Take a shared lock on the lock file of a resource, before its files are
+ * opened. *writer is set if the context may also add to the cache. */
+static int lock_path(const char *path, int *writer)
+{
+    LockedPath *lp, *tmp;
+    int i, fd = -1, ret = 0;
+
+    ff_mutex_lock(&locked_mutex);
+    for (i = 0; i < nb_locked_paths; i++)
+        if (!strcmp(locked_paths[i].path, path))
+            break;
+    if (i == nb_locked_paths) {
+        /* Eviction may unlink the lock file between open() and the lock,
+         * in which case it is created again. */
+        do {
+            if (fd >= 0)
+                close(fd);
+            fd = avpriv_open(path, O_RDWR | O_CREAT, 0666);
+            if (fd < 0 || lock_range(fd, F_RDLCK, 1) < 0) {
+                ret = AVERROR(errno);
+                goto fail;
+            }
+        } while (!same_file(fd, path));
+        tmp = av_realloc_array(locked_paths, nb_locked_paths + 1, sizeof(*tmp));
+        if (!tmp) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        locked_paths = tmp;
+        lp = &locked_paths[nb_locked_paths];
+        *lp = (LockedPath) { .path = av_strdup(path), .fd = fd };
+        if (!lp->path) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        nb_locked_paths++;
+    }
+    lp = &locked_paths[i];
+    lp->users++;
+    *writer = !lp->writer && lock_range(lp->fd, F_WRLCK, 0) >= 0;
+    lp->writer |= *writer;
+    ff_mutex_unlock(&locked_mutex);
+    return 0;
+
+fail:
+    if (fd >= 0)
+        close(fd);
+    ff_mutex_unlock(&locked_mutex);
+    return ret;
+}
+
+/* Release the locks taken by lock_path(). The descriptor is closed under
+ * locked_mutex, as another context could otherwise lock the path again
+ * in between and lose its lock on that close(). */
+static void unlock_path(const char *path, int writer)
+{
+    int i;
+
+    ff_mutex_lock(&locked_mutex);
+    for (i = 0; i < nb_locked_paths; i++) {
+        LockedPath *lp = &locked_paths[i];
+        if (strcmp(lp->path, path))
+            continue;
+        if (writer) {
+            lock_range(lp->fd, F_UNLCK, 0);
+            lp->writer = 0;
+        }
+        if (!--lp->users) {
+            close(lp->fd);
+            av_free(lp->path);
+            *lp = locked_paths[--nb_locked_paths];
+        }
+        break;
+    }
+    if (!nb_locked_paths)
+        av_freep(&locked_paths);
+    ff_mutex_unlock(&locked_mutex);
+}
+
+/* Delete the files of a resource, unless a context of this or another
+ * process uses it. Closing the descriptor drops every lock this process
+ * holds on the lock file, so this runs under locked_mutex and only on
+ * paths that no context of this process has locked. */
+static int remove_unused(const char *lock, const char *bin, const char *idx)
+{
+    int i, fd, ret = 0;
+
+    ff_mutex_lock(&locked_mutex);
+    for (i = 0; i < nb_locked_paths; i++)
+        if (!strcmp(locked_paths[i].path, lock))
+            goto end;
+
+    fd = avpriv_open(lock, O_RDWR);
+    if (fd < 0)
+        goto end;
+    if (lock_range(fd, F_WRLCK, 1) >= 0 && same_file(fd, lock)) {
+        unlink(idx);
+        unlink(bin);
+        unlink(lock);
+        ret = 1;
+    }
+    close(fd);
+end:
+    ff_mutex_unlock(&locked_mutex);
+    return ret;
+}
+
+/**
+ * The key of a resource combines its url with the validators exported by
+ * the inner protocol, so that a changed resource gets a new cache file.
+ */
+static char *resource_key(URLContext *h, const char *url)
+{
+    Context *c = h->priv_data;
+    static const char * const validators[] = { "etag", "last_modified", NULL };
+    struct AVHashContext *hash;
+    uint8_t *val, hex[2 * 32 + 1];
+    char buf[32];
+    int64_t size;
+    int i, nb_validators = 0;
+
+    size = ffurl_seek(c->inner, 0, AVSEEK_SIZE);
+    if (av_hash_alloc(&hash, "SHA256") < 0)
+        return NULL;
+    av_hash_init(hash);
+    av_hash_update(hash, (const uint8_t *)url, strlen(url) + 1);
+    snprintf(buf, sizeof(buf), "%"PRId64, size);
+    av_hash_update(hash, (const uint8_t *)buf, strlen(buf) + 1);
+    nb_validators += size > 0;
+    for (i = 0; validators[i]; i++) {
+        if (av_opt_get(c->inner, validators[i], AV_OPT_SEARCH_CHILDREN, &val) >= 0) {
+            if (val && *val) {
+                av_hash_update(hash, val, strlen((char *)val) + 1);
+                nb_validators++;
+            }
+            av_free(val);
+        }
+    }
+    av_hash_final_hex(hash, hex, sizeof(hex));
+    av_hash_freep(&hash);
+
+    if (!nb_validators) {
+        av_log(h, AV_LOG_VERBOSE, "No size or validator for '%s', not caching it persistently\n", url);
+        return NULL;
+    }
+    return av_asprintf("%s/%s", c->cache_dir, hex);
+}
+
+static int read_index(URLContext *h)
+{
+    Context *c = h->priv_data;
+    uint8_t header[INDEX_HEADER_SIZE], buf[INDEX_ENTRY_SIZE];
+    struct AVTreeNode *node;
+    CacheEntry *entry;
+    char *name;
+    int fd, ret = 0;
+
+    if (!(name = av_asprintf("%s.idx", c->path)))
+        return AVERROR(ENOMEM);
+    fd = avpriv_open(name, O_RDONLY);
+    av_free(name);
+    if (fd < 0)
+        return 0;
+
+    if (read(fd, header, sizeof(header)) != sizeof(header) ||
+        AV_RL32(header) != INDEX_MAGIC || AV_RL32(header + 4) != INDEX_VERSION)
+        goto end;
+    c->end         = AV_RL64(header + 8);
+    c->is_true_eof = AV_RL32(header + 16);
+
+    while (read(fd, buf, sizeof(buf)) == sizeof(buf)) {
+        entry = av_malloc(sizeof(*entry));
+        node  = av_tree_node_alloc();
+        if (!entry || !node) {
+            av_free(entry);
+            av_free(node);
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        entry->logical_pos  = AV_RL64(buf);
+        entry->physical_pos = AV_RL64(buf + 8);
+        entry->size         = AV_RL32(buf + 16);
+        entry->shared       = !c->writer;
+        av_tree_insert(&c->root, entry, cmp, &node);
+        if (node) {
+            av_free(entry);
+            av_free(node);
+        }
+    }
+end:
+    close(fd);
+    return ret;
+}
+
+typedef struct IndexWriter {
+    int fd;
+    int ret;
+} IndexWriter;
+
+static int write_index_entry(void *opaque, void *elem)
+{
+    IndexWriter *w = opaque;
+    CacheEntry *entry = elem;
+    uint8_t buf[INDEX_ENTRY_SIZE];
+
+    AV_WL64(buf,      entry->logical_pos);
+    AV_WL64(buf +  8, entry->physical_pos);
+    AV_WL32(buf + 16, entry->size);
+    if (!w->ret && write(w->fd, buf, sizeof(buf)) != sizeof(buf))
+        w->ret = AVERROR(EIO);
+    return 0;
+}
+
+/* The index is replaced atomically, so that readers always see a
+ * consistent one. Rewriting it also marks the resource as recently used. */
+static int write_index(URLContext *h)
+{
+    Context *c = h->priv_data;
+    uint8_t header[INDEX_HEADER_SIZE];
+    IndexWriter w = { 0 };
+    char *name, *tmp;
+    int ret;
+
+    name = av_asprintf("%s.idx", c->path);
+    tmp  = av_asprintf("%s.idx.tmp", c->path);
+    if (!name || !tmp) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    w.fd = avpriv_open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (w.fd < 0) {
+        ret = AVERROR(errno);
+        goto end;
+    }
+    AV_WL32(header,      INDEX_MAGIC);
+    AV_WL32(header +  4, INDEX_VERSION);
+    AV_WL64(header +  8, c->end);
+    AV_WL32(header + 16, c->is_true_eof);
+    if (write(w.fd, header, sizeof(header)) != sizeof(header))
+        w.ret = AVERROR(EIO);
+    av_tree_enumerate(c->root, &w, NULL, write_index_entry);
+    close(w.fd);
+    ret = w.ret;
+    if (!ret)
+        ret = ff_rename(tmp, name, h);
+    if (ret < 0)
+        unlink(tmp);
+end:
+    av_free(name);
+    av_free(tmp);
+    return ret;
+}
+
+typedef struct CacheFile {
+    char *path;
+    int64_t size;
+    int64_t mtime;
+} CacheFile;
+
+static int cmp_mtime(const void *a, const void *b)
+{
+    return FFDIFFSIGN(((const CacheFile *)a)->mtime, ((const CacheFile *)b)->mtime);
+}
+
+/* Delete the least recently used resources until the cache fits. */
+static void evict(URLContext *h)
+{
+    Context *c = h->priv_data;
+    AVIODirContext *dir = NULL;
+    AVIODirEntry *de;
+    CacheFile *files = NULL, *tmp;
+    int64_t total = 0;
+    int i, nb_files = 0;
+
+    if (avio_open_dir(&dir, c->cache_dir, NULL) < 0)
+        return;
+    while (avio_read_dir(dir, &de) >= 0 && de) {
+        size_t len = strlen(de->name);
+        if (de->type == AVIO_ENTRY_FILE && len > 4 &&
+            (!strcmp(de->name + len - 4, ".bin") || !strcmp(de->name + len - 4, ".idx"))) {
+            total += de->size;
+            for (i = 0; i < nb_files; i++)
+                if (!strncmp(files[i].path, de->name, len - 4) && !files[i].path[len - 4])
+                    break;
+            if (i == nb_files &&
+                (tmp = av_realloc_array(files, nb_files + 1, sizeof(*files)))) {
+                files = tmp;
+                files[i].path  = av_strndup(de->name, len - 4);
+                files[i].size  = 0;
+                files[i].mtime = INT64_MIN;
+                nb_files += !!files[i].path;
+            }
+            if (i < nb_files) {
+                files[i].size += de->size;
+                if (!strcmp(de->name + len - 4, ".idx"))
+                    files[i].mtime = de->modification_timestamp;
+            }
+        }
+        avio_free_directory_entry(&de);
+    }
+    avio_close_dir(&dir);
+
+    qsort(files, nb_files, sizeof(*files), cmp_mtime);
+    for (i = 0; i < nb_files && total > c->cache_max_size; i++) {
+        char *base = av_asprintf("%s/%s", c->cache_dir, files[i].path);
+        char *bin  = base ? av_asprintf("%s.bin", base) : NULL;
+        char *idx  = base ? av_asprintf("%s.idx", base) : NULL;
+        char *lock = base ? av_asprintf("%s.lock", base) : NULL;
+        if (bin && idx && lock && strcmp(base, c->path) &&
+            remove_unused(lock, bin, idx)) {
+            av_log(h, AV_LOG_DEBUG, "Evicted %s\n", base);
+            total -= files[i].size;
+        }
+        av_free(base);
+        av_free(bin);
+        av_free(idx);
+        av_free(lock);
+    }
+    for (i = 0; i < nb_files; i++)
+        av_free(files[i].path);
+    av_free(files);
+}
+
+static void close_persistent(URLContext *h)
+{
+    Context *c = h->priv_data;
+
+    av_tree_enumerate(c->root, NULL, NULL, enu_free);
+    av_tree_destroy(c->root);
+    c->root = NULL;
+    c->end = c->is_true_eof = 0;
+    if (c->writer) {
+        close(c->fd);
+        c->fd = -1;
+    }
+    if (c->shared_fd >= 0)
+        close(c->shared_fd);
+    c->shared_fd = -1;
+    /* the files are closed first, eviction may delete them once unlocked */
+    if (c->locked) {
+        char *name = av_asprintf("%s.lock", c->path);
+        if (name)
+            unlock_path(name, c->writer);
+        av_free(name);
+    }
+    c->locked = c->writer = 0;
+    av_freep(&c->path);
+}
+
+static int open_persistent(URLContext *h, const char *url)
+{
+    Context *c = h->priv_data;
+    char *name;
+    int ret;
+
+    if (!(c->path = resource_key(h, url)))
+        return AVERROR(ENOSYS);
+
+    /* lock before opening, so that the files are not evicted meanwhile */
+    if (!(name = av_asprintf("%s.lock", c->path)))
+        return AVERROR(ENOMEM);
+    ret = lock_path(name, &c->writer);
+    if (ret < 0) {
+        av_log(h, AV_LOG_WARNING, "Failed to lock cache file %s\n", name);
+        av_free(name);
+        return ret;
+    }
+    c->locked = 1;
+    av_free(name);
+
+    if (!(name = av_asprintf("%s.bin", c->path)))
+        return AVERROR(ENOMEM);
+    c->shared_fd = avpriv_open(name, O_RDWR | O_CREAT, 0666);
+    if (c->shared_fd < 0) {
+        ret = AVERROR(errno);
+        av_log(h, AV_LOG_WARNING, "Failed to open cache file %s\n", name);
+        av_free(name);
+        return ret;
+    }
+    av_free(name);
+
+    if (c->writer) {
+        /* new data is appended to the shared file */
+        c->fd = c->shared_fd;
+        c->shared_fd = -1;
+    } else {
+        av_log(h, AV_LOG_VERBOSE, "Cache of '%s' is being written elsewhere, using it read-only\n", url);
+    }
+    return read_index(h);
+}
+#endif
+
 static int cache_open(URLContext *h, const char *arg, int flags, AVDictionary **options)
 {
     char *buffername;
     Context *c= h->priv_data;
+    int ret;
 
     av_strstart(arg, "cache:", &arg);
 
+    c->fd = c->shared_fd = -1;
+    ret = ffurl_open_whitelist(&c->inner, arg, flags, &h->interrupt_callback,
+                               options, h->protocol_whitelist, h->protocol_blacklist, h);
+    if (ret < 0)
+        return ret;
+
+    if (c->cache_dir) {
+#if HAVE_FCNTL
+        if ((ret = open_persistent(h, arg)) < 0) {
+            close_persistent(h);
+            if (ret == AVERROR(ENOMEM))
+                goto fail;
+        }
+        if (c->fd >= 0)
+            return 0;
+#else
+        av_log(h, AV_LOG_WARNING, "Persistent caching is not supported on this platform\n");
+#endif
+    }
+
     c->fd = avpriv_tempfile("ffcache", &buffername, 0, h);
     if (c->fd < 0){
         av_log(h, AV_LOG_ERROR, "Failed to create tempfile\n");
-        return c->fd;
+        ret = c->fd;
+        goto fail;
     }
 
     unlink(buffername);
     av_freep(&buffername);
 
-    return ffurl_open_whitelist(&c->inner, arg, flags, &h->interrupt_callback,
-                                options, h->protocol_whitelist, h->protocol_blacklist, h);
+    return 0;
+fail:
+#if HAVE_FCNTL
+    close_persistent(h);
+#endif
+    ffurl_closep(&c->inner);
+    return ret;
 }
 
 static int add_entry(URLContext *h, const unsigned char *buf, int size)
@@ -121,7 +597,7 @@ static int add_entry(URLContext *h, const unsigned char *buf, int size)
     if (!entry)
         entry = next[0];
 
-    if (!entry ||
+    if (!entry || entry->shared ||
         entry->logical_pos  + entry->size != c->logical_pos ||
         entry->physical_pos + entry->size != pos
     ) {
@@ -134,6 +610,7 @@ static int add_entry(URLContext *h, const unsigned char *buf, int size)
         entry->logical_pos = c->logical_pos;
         entry->physical_pos = pos;
         entry->size = ret;
+        entry->shared = 0;
 
         entry_ret = av_tree_insert(&c->root, entry, cmp, &node);
         if (entry_ret && entry_ret != entry) {
@@ -169,19 +646,22 @@ static int cache_read(URLContext *h, unsigned char *buf, int size)
         av_assert0(entry->logical_pos <= c->logical_pos);
         if (in_block_pos < entry->size) {
             int64_t physical_target = entry->physical_pos + in_block_pos;
+            int fd = entry->shared ? c->shared_fd : c->fd;
 
-            if (c->cache_pos != physical_target) {
-                r = lseek(c->fd, physical_target, SEEK_SET);
+            if (entry->shared || c->cache_pos != physical_target) {
+                r = lseek(fd, physical_target, SEEK_SET);
             } else
                 r = c->cache_pos;
 
             if (r >= 0) {
-                c->cache_pos = r;
-                r = read(c->fd, buf, FFMIN(size, entry->size - in_block_pos));
+                if (!entry->shared)
+                    c->cache_pos = r;
+                r = read(fd, buf, FFMIN(size, entry->size - in_block_pos));
             }
 
             if (r > 0) {
-                c->cache_pos += r;
+                if (!entry->shared)
+                    c->cache_pos += r;
                 c->logical_pos += r;
                 c->cache_hit ++;
                 return r;
@@ -283,12 +763,6 @@ resolve_eof:
     return ret;
 }
 
-static int enu_free(void *opaque, void *elem)
-{
-    av_free(elem);
-    return 0;
-}
-
 static int cache_close(URLContext *h)
 {
     Context *c= h->priv_data;
@@ -296,7 +770,17 @@ static int cache_close(URLContext *h)
     av_log(h, AV_LOG_INFO, "Statistics, cache hits:%"PRId64" cache misses:%"PRId64"\n",
            c->cache_hit, c->cache_miss);
 
-    close(c->fd);
+#if HAVE_FCNTL
+    if (c->writer) {
+        if (write_index(h) < 0)
+            av_log(h, AV_LOG_WARNING, "Failed to write the cache index of %s\n", c->path);
+        if (c->cache_max_size > 0)
+            evict(h);
+    }
+    close_persistent(h);
+#endif
+    if (c->fd >= 0)
+        close(c->fd);
     ffurl_close(c->inner);
     av_tree_enumerate(c->root, NULL, NULL, enu_free);
     av_tree_destroy(c->root);
@@ -309,6 +793,8 @@ static int cache_close(URLContext *h)
 
 static const AVOption options[] = {
     { "read_ahead_limit", "Amount in bytes that may be read ahead when seeking isn't supported, -1 for unlimited", OFFSET(read_ahead_limit), AV_OPT_TYPE_INT, { .i64 = 65536 }, -1, INT_MAX, D },
+    { "cache_dir", "Directory in which the cache is kept across sessions", OFFSET(cache_dir), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, D },
+    { "cache_max_size", "Maximum size in bytes of the persistent cache, 0 for unlimited", OFFSET(cache_max_size), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D },
     {NULL},
 };
 
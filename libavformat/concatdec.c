@@ -18,12 +18,14 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/bprint.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
+#include "libavutil/thread.h"
 #include "libavutil/timestamp.h"
 #include "avformat.h"
 #include "internal.h"
@@ -51,6 +53,7 @@ typedef struct {
     int64_t outpoint;
     AVDictionary *metadata;
     int nb_streams;
+    AVInputFormat *iformat;
 } ConcatFile;
 
 typedef struct {
@@ -65,6 +68,15 @@ typedef struct {
     ConcatMatchMode stream_match_mode;
     unsigned auto_convert;
     int segment_time_metadata;
+    int64_t prefetch;
+    AVFormatContext *prefetch_avf;
+    AVInputFormat *prefetch_fmt;
+    unsigned prefetch_fileno;
+    int prefetch_ret;
+    int prefetch_started;
+#if HAVE_THREADS
+    pthread_t prefetch_thread;
+#endif
 } ConcatContext;
 
 static int concat_probe(AVProbeData *probe)
@@ -314,31 +326,123 @@ static int match_streams(AVFormatContext *avf)
     return 0;
 }
 
-static int open_file(AVFormatContext *avf, unsigned fileno)
+/* Return the input format an earlier entry with the same URL was opened
+ * with, so that probing can be skipped when a playlist repeats files. */
+static AVInputFormat *find_cached_format(ConcatContext *cat, const char *url)
 {
-    ConcatContext *cat = avf->priv_data;
-    ConcatFile *file = &cat->files[fileno];
-    int ret;
+    unsigned i;
 
-    if (cat->avf)
-        avformat_close_input(&cat->avf);
+    for (i = 0; i < cat->nb_files; i++)
+        if (cat->files[i].iformat && !strcmp(cat->files[i].url, url))
+            return cat->files[i].iformat;
+    return NULL;
+}
 
-    cat->avf = avformat_alloc_context();
-    if (!cat->avf)
+/* Must not modify the parent context: it may run in the prefetch thread. */
+static int open_input(AVFormatContext *avf, const char *url, AVInputFormat *fmt,
+                      AVFormatContext **ps)
+{
+    AVFormatContext *s;
+    int ret;
+
+    s = avformat_alloc_context();
+    if (!s)
         return AVERROR(ENOMEM);
 
-    cat->avf->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
-    cat->avf->interrupt_callback = avf->interrupt_callback;
+    s->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
+    s->interrupt_callback = avf->interrupt_callback;
 
-    if ((ret = ff_copy_whiteblacklists(cat->avf, avf)) < 0)
+    if ((ret = ff_copy_whiteblacklists(s, avf)) < 0) {
+        avformat_free_context(s);
         return ret;
+    }
 
-    if ((ret = avformat_open_input(&cat->avf, file->url, NULL, NULL)) < 0 ||
-        (ret = avformat_find_stream_info(cat->avf, NULL)) < 0) {
-        av_log(avf, AV_LOG_ERROR, "Impossible to open '%s'\n", file->url);
-        avformat_close_input(&cat->avf);
+    if ((ret = avformat_open_input(&s, url, fmt, NULL)) < 0) {
+        if (fmt)
+            return open_input(avf, url, NULL, ps);
         return ret;
     }
+    if ((ret = avformat_find_stream_info(s, NULL)) < 0) {
+        avformat_close_input(&s);
+        return ret;
+    }
+    *ps = s;
+    return 0;
+}
+
+#if HAVE_THREADS
+static void *prefetch_thread(void *arg)
+{
+    AVFormatContext *avf = arg;
+    ConcatContext *cat = avf->priv_data;
+
+    cat->prefetch_ret = open_input(avf, cat->files[cat->prefetch_fileno].url,
+                                   cat->prefetch_fmt, &cat->prefetch_avf);
+    return NULL;
+}
+#endif
+
+static void start_prefetch(AVFormatContext *avf, unsigned fileno)
+{
+#if HAVE_THREADS
+    ConcatContext *cat = avf->priv_data;
+    int ret;
+
+    cat->prefetch_avf    = NULL;
+    cat->prefetch_fmt    = find_cached_format(cat, cat->files[fileno].url);
+    cat->prefetch_fileno = fileno;
+    cat->prefetch_ret    = 0;
+    ret = pthread_create(&cat->prefetch_thread, NULL, prefetch_thread, avf);
+    if (ret) {
+        av_log(avf, AV_LOG_WARNING, "Could not start prefetching '%s': %s\n",
+               cat->files[fileno].url, av_err2str(AVERROR(ret)));
+        /* do not retry for every packet */
+        cat->prefetch_started = -1;
+        return;
+    }
+    cat->prefetch_started = 1;
+#endif
+}
+
+/* Wait for the prefetch thread and return the context it opened, if any. */
+static AVFormatContext *finish_prefetch(ConcatContext *cat, unsigned *fileno)
+{
+#if HAVE_THREADS
+    if (cat->prefetch_started > 0) {
+        pthread_join(cat->prefetch_thread, NULL);
+        cat->prefetch_started = 0;
+        *fileno = cat->prefetch_fileno;
+        return cat->prefetch_ret < 0 ? NULL : cat->prefetch_avf;
+    }
+#endif
+    cat->prefetch_started = 0;
+    return NULL;
+}
+
+static int open_file(AVFormatContext *avf, unsigned fileno)
+{
+    ConcatContext *cat = avf->priv_data;
+    ConcatFile *file = &cat->files[fileno];
+    AVFormatContext *prefetched;
+    unsigned prefetched_fileno;
+    int ret;
+
+    if (cat->avf)
+        avformat_close_input(&cat->avf);
+
+    prefetched = finish_prefetch(cat, &prefetched_fileno);
+    if (prefetched && prefetched_fileno == fileno) {
+        cat->avf = prefetched;
+    } else {
+        avformat_close_input(&prefetched);
+        ret = open_input(avf, file->url, find_cached_format(cat, file->url),
+                         &cat->avf);
+        if (ret < 0) {
+            av_log(avf, AV_LOG_ERROR, "Impossible to open '%s'\n", file->url);
+            return ret;
+        }
+    }
+    file->iformat = cat->avf->iformat;
     cat->cur_file = file;
     if (file->start_time == AV_NOPTS_VALUE)
         file->start_time = !fileno ? 0 :
@@ -367,8 +471,11 @@ static int open_file(AVFormatContext *avf, unsigned fileno)
 static int concat_read_close(AVFormatContext *avf)
 {
     ConcatContext *cat = avf->priv_data;
+    AVFormatContext *prefetched;
     unsigned i, j;
 
+    prefetched = finish_prefetch(cat, &i);
+    avformat_close_input(&prefetched);
     for (i = 0; i < cat->nb_files; i++) {
         av_freep(&cat->files[i].url);
         for (j = 0; j < cat->files[i].nb_streams; j++) {
@@ -555,6 +662,34 @@ static int filter_packet(AVFormatContext *avf, ConcatStream *cs, AVPacket *pkt)
     return 0;
 }
 
+/* Start opening the next file once the packet is within the prefetch window
+ * of the end of the current one. */
+static void check_prefetch(AVFormatContext *avf, AVPacket *pkt)
+{
+    ConcatContext *cat = avf->priv_data;
+    ConcatFile *file = cat->cur_file;
+    unsigned fileno = file - cat->files;
+    int64_t end, pos;
+
+    if (!cat->prefetch || cat->prefetch_started ||
+        fileno + 1 >= cat->nb_files || pkt->dts == AV_NOPTS_VALUE)
+        return;
+
+    if (file->outpoint != AV_NOPTS_VALUE)
+        end = file->outpoint;
+    else if (file->duration != AV_NOPTS_VALUE)
+        end = file->file_inpoint + file->duration;
+    else if (cat->avf->duration > 0)
+        end = file->file_start_time + cat->avf->duration;
+    else
+        return;
+
+    pos = av_rescale_q(pkt->dts, cat->avf->streams[pkt->stream_index]->time_base,
+                       AV_TIME_BASE_Q);
+    if (end - pos <= cat->prefetch)
+        start_prefetch(avf, fileno + 1);
+}
+
 /* Returns true if the packet dts is greater or equal to the specified outpoint. */
 static int packet_after_outpoint(ConcatContext *cat, AVPacket *pkt)
 {
@@ -608,6 +743,8 @@ static int concat_read_packet(AVFormatContext *avf, AVPacket *pkt)
     if ((ret = filter_packet(avf, cs, pkt)))
         return ret;
 
+    check_prefetch(avf, pkt);
+
     st = cat->avf->streams[pkt->stream_index];
     av_log(avf, AV_LOG_DEBUG, "file:%d stream:%d pts:%s pts_time:%s dts:%s dts_time:%s",
            (unsigned)(cat->cur_file - cat->files), pkt->stream_index,
@@ -759,6 +896,8 @@ static const AVOption options[] = {
       OFFSET(auto_convert), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, DEC },
     { "segment_time_metadata", "output file segment start time and duration as packet metadata",
       OFFSET(segment_time_metadata), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, DEC },
+    { "prefetch", "open the next file in the background this long before the end of the current one",
+      OFFSET(prefetch), AV_OPT_TYPE_DURATION, {.i64 = 0}, 0, INT64_MAX, DEC },
     { NULL }
 };
 
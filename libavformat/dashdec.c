@@ -1763,7 +1763,7 @@ end:
 static int save_avio_options(AVFormatContext *s)
 {
     DASHContext *c = s->priv_data;
-    const char *opts[] = { "headers", "user_agent", "cookies", NULL }, **opt = opts;
+    const char *opts[] = { "headers", "user_agent", "cookies", "connection_pool", NULL }, **opt = opts;
     uint8_t *buf = NULL;
     int ret = 0;
 
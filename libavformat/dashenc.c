@@ -32,6 +32,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/rational.h"
+#include "libavutil/thread.h"
 #include "libavutil/time_internal.h"
 
 #include "avc.h"
@@ -64,6 +65,15 @@ typedef struct Segment {
     int n;
 } Segment;
 
+typedef struct DASHUploadJob {
+    char *temp_path;            ///< file written (or deleted) by the job
+    char *path;                 ///< name temp_path is moved to, NULL if none
+    uint8_t *data;
+    int size;
+    int delete;
+    struct DASHUploadJob *next;
+} DASHUploadJob;
+
 typedef struct AdaptationSet {
     char id[10];
     enum AVMediaType media_type;
@@ -134,10 +144,25 @@ typedef struct DASHContext {
     AVIOContext *mpd_out;
     AVIOContext *m3u8_out;
     int streaming;
+    int64_t frag_duration;
     int64_t timeout;
     int index_correction;
     char *format_options_str;
     SegmentType segment_type_option;  /* segment type as specified in options */
+    int async_upload;
+    int upload_queue_size;
+    DASHUploadJob *upload_head, **upload_tail;
+    int nb_upload_jobs;
+    int upload_error;
+    int upload_done;
+    int upload_abort;
+    AVIOContext *upload_out;    ///< persistent HTTP connection of the upload thread
+#if HAVE_THREADS
+    int upload_thread_started;
+    pthread_t upload_thread;
+    pthread_mutex_t upload_mutex;
+    pthread_cond_t upload_cond;
+#endif
 } DASHContext;
 
 static struct codec_string {
@@ -200,6 +225,283 @@ static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filenam
     }
 }
 
+static void set_http_options(AVDictionary **options, DASHContext *c);
+static void dashenc_delete_file(AVFormatContext *s, char *filename);
+
+static void free_upload_job(DASHUploadJob *job)
+{
+    av_freep(&job->temp_path);
+    av_freep(&job->path);
+    av_freep(&job->data);
+    av_free(job);
+}
+
+/* The upload thread opens its outputs through the protocols directly, with
+ * the interrupt callback and protocol lists of the context. s->io_open and
+ * s->io_close are not used there: they may not be thread-safe. */
+static int upload_io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                          int flags, AVDictionary **options)
+{
+    return ffio_open_whitelist(pb, url, flags, &s->interrupt_callback,
+                               options, s->protocol_whitelist,
+                               s->protocol_blacklist);
+}
+
+#if CONFIG_HTTP_PROTOCOL
+/**
+ * End the request body and consume the response, so that the next request
+ * on the connection does not leave it unread. Closing a connection with
+ * unread responses resets it, and the server may drop requests it has not
+ * processed yet.
+ */
+static int end_http_request(AVFormatContext *s, URLContext *uc)
+{
+    uint8_t buf[1024];
+    int ret = ffurl_shutdown(uc, AVIO_FLAG_READ_WRITE);
+
+    while (ret >= 0)
+        ret = ffurl_read(uc, buf, sizeof(buf));
+    if (ret == AVERROR_EOF)
+        return 0;
+    av_log(s, AV_LOG_ERROR, "Upload to %s failed: %s\n", uc->filename,
+           av_err2str(ret));
+    return ret;
+}
+#endif
+
+static int run_upload_job(AVFormatContext *s, DASHUploadJob *job)
+{
+    DASHContext *c = s->priv_data;
+    int persistent = c->http_persistent && ff_is_http_proto(job->temp_path);
+    AVIOContext *out = NULL;
+    AVDictionary *opts = NULL;
+    int ret;
+
+    if (job->delete) {
+        if (!ff_is_http_proto(job->temp_path)) {
+            dashenc_delete_file(s, job->temp_path);
+            return 0;
+        }
+        set_http_options(&opts, c);
+        av_dict_set(&opts, "method", "DELETE", 0);
+        if (upload_io_open(s, &out, job->temp_path, AVIO_FLAG_WRITE, &opts) < 0)
+            av_log(s, AV_LOG_ERROR, "failed to delete %s\n", job->temp_path);
+        av_dict_free(&opts);
+        avio_closep(&out);
+        return 0;
+    }
+
+#if CONFIG_HTTP_PROTOCOL
+    /* reuse the connection of the previous upload, like dashenc_io_open() */
+    if (persistent && c->upload_out) {
+        out = c->upload_out;
+        c->upload_out = NULL;
+        if (ff_http_do_new_request(ffio_geturlcontext(out), job->temp_path) < 0)
+            avio_closep(&out);
+    }
+#endif
+    if (!out) {
+        set_http_options(&opts, c);
+        /* a persistent connection is also read, see end_http_request() */
+        ret = upload_io_open(s, &out, job->temp_path,
+                             persistent ? AVIO_FLAG_READ_WRITE : AVIO_FLAG_WRITE,
+                             &opts);
+        av_dict_free(&opts);
+        if (ret < 0) {
+            av_log(s, AV_LOG_ERROR, "Unable to open %s for writing\n", job->temp_path);
+            return ret;
+        }
+    }
+    avio_write(out, job->data, job->size);
+    avio_flush(out);
+    ret = out->error;
+#if CONFIG_HTTP_PROTOCOL
+    if (persistent && ret >= 0)
+        ret = end_http_request(s, ffio_geturlcontext(out));
+    if (persistent && ret >= 0) {
+        c->upload_out = out;
+        out = NULL;
+    }
+#endif
+    avio_closep(&out);
+    if (ret < 0)
+        return ret;
+
+    if (job->path)
+        ret = avpriv_io_move(job->temp_path, job->path);
+    return ret;
+}
+
+#if HAVE_THREADS
+static void *upload_thread(void *arg)
+{
+    AVFormatContext *s = arg;
+    DASHContext *c = s->priv_data;
+
+    pthread_mutex_lock(&c->upload_mutex);
+    for (;;) {
+        DASHUploadJob *job;
+        int ret = 0;
+
+        while (!c->upload_head && !c->upload_done)
+            pthread_cond_wait(&c->upload_cond, &c->upload_mutex);
+        if (!c->upload_head)
+            break;
+
+        /* Keep the job queued while it runs, so that it counts against
+         * upload_queue_size. Once an upload failed, the remaining jobs
+         * are dropped: a manifest must not reference a missing segment.
+         * They are also dropped when muxing is aborted. */
+        job = c->upload_head;
+        if (!c->upload_error && !c->upload_abort) {
+            pthread_mutex_unlock(&c->upload_mutex);
+            ret = run_upload_job(s, job);
+            pthread_mutex_lock(&c->upload_mutex);
+        }
+
+        c->upload_head = job->next;
+        if (!c->upload_head)
+            c->upload_tail = &c->upload_head;
+        c->nb_upload_jobs--;
+        if (ret < 0 && !c->upload_error)
+            c->upload_error = ret;
+        pthread_cond_broadcast(&c->upload_cond);
+        free_upload_job(job);
+    }
+    pthread_mutex_unlock(&c->upload_mutex);
+
+    return NULL;
+}
+
+static int start_upload_thread(AVFormatContext *s)
+{
+    DASHContext *c = s->priv_data;
+    int ret;
+
+    c->upload_tail = &c->upload_head;
+    if ((ret = pthread_mutex_init(&c->upload_mutex, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&c->upload_cond, NULL))) {
+        pthread_mutex_destroy(&c->upload_mutex);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&c->upload_thread, NULL, upload_thread, s))) {
+        pthread_cond_destroy(&c->upload_cond);
+        pthread_mutex_destroy(&c->upload_mutex);
+        return AVERROR(ret);
+    }
+    c->upload_thread_started = 1;
+    return 0;
+}
+
+/**
+ * Stop the upload thread. Waits for all queued uploads, unless discard is
+ * set, in which case only the running upload is finished and the pending
+ * ones are dropped.
+ */
+static int stop_upload_thread(AVFormatContext *s, int discard)
+{
+    DASHContext *c = s->priv_data;
+
+    if (!c->upload_thread_started)
+        return 0;
+
+    pthread_mutex_lock(&c->upload_mutex);
+    c->upload_done  = 1;
+    c->upload_abort = discard;
+    pthread_cond_broadcast(&c->upload_cond);
+    pthread_mutex_unlock(&c->upload_mutex);
+    pthread_join(c->upload_thread, NULL);
+    pthread_cond_destroy(&c->upload_cond);
+    pthread_mutex_destroy(&c->upload_mutex);
+    c->upload_thread_started = 0;
+    avio_closep(&c->upload_out);
+
+    return c->upload_error;
+}
+#endif
+
+/**
+ * Hand a finished file to the upload thread. The data is written to
+ * temp_path, which is then moved to path if that is set. Takes ownership
+ * of data, and blocks while upload_queue_size jobs are pending.
+ */
+static int queue_upload(AVFormatContext *s, const char *temp_path,
+                        const char *path, uint8_t *data, int size, int delete)
+{
+    DASHContext *c = s->priv_data;
+    DASHUploadJob *job = av_mallocz(sizeof(*job));
+    int ret = 0;
+
+    if (!job) {
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+    job->data      = data;
+    job->size      = size;
+    job->delete    = delete;
+    job->temp_path = av_strdup(temp_path);
+    job->path      = path ? av_strdup(path) : NULL;
+    if (!job->temp_path || (path && !job->path)) {
+        free_upload_job(job);
+        return AVERROR(ENOMEM);
+    }
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&c->upload_mutex);
+    while (c->nb_upload_jobs >= c->upload_queue_size && !c->upload_error)
+        pthread_cond_wait(&c->upload_cond, &c->upload_mutex);
+    ret = c->upload_error;
+    if (!ret) {
+        *c->upload_tail = job;
+        c->upload_tail  = &job->next;
+        c->nb_upload_jobs++;
+        job = NULL;
+        pthread_cond_broadcast(&c->upload_cond);
+    }
+    pthread_mutex_unlock(&c->upload_mutex);
+#else
+    ret = AVERROR(ENOSYS);
+#endif
+    if (job)
+        free_upload_job(job);
+    return ret;
+}
+
+/* Open a manifest or playlist; with async_upload it is built in memory. */
+static int dashenc_output_open(AVFormatContext *s, AVIOContext **pb, char *filename,
+                               AVDictionary **options)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->async_upload)
+        return avio_open_dyn_buf(pb);
+    return dashenc_io_open(s, pb, filename, options);
+}
+
+/* Close a manifest or playlist and move it from temp_filename to filename
+ * if the latter is set; with async_upload this is queued. */
+static int dashenc_output_close(AVFormatContext *s, AVIOContext **pb,
+                                char *temp_filename, const char *filename)
+{
+    DASHContext *c = s->priv_data;
+
+    if (!*pb)
+        return 0;
+
+    if (c->async_upload) {
+        uint8_t *buf;
+        int size = avio_close_dyn_buf(*pb, &buf);
+        *pb = NULL;
+        return queue_upload(s, temp_filename, filename, buf, size, 0);
+    }
+
+    dashenc_io_close(s, pb, temp_filename);
+    if (filename)
+        return avpriv_io_move(temp_filename, filename);
+    return 0;
+}
+
 static const char *get_format_str(SegmentType segment_type) {
     int i;
     for (i = 0; i < SEGMENT_TYPE_NB; i++)
@@ -346,7 +648,7 @@ static void set_codec_str(AVFormatContext *s, AVCodecParameters *par,
     }
 }
 
-static int flush_dynbuf(OutputStream *os, int *range_length)
+static int flush_dynbuf(OutputStream *os, int *range_length, uint8_t **out_buf)
 {
     uint8_t *buffer;
 
@@ -364,7 +666,10 @@ static int flush_dynbuf(OutputStream *os, int *range_length)
     if (os->out)
         avio_write(os->out, buffer + os->written_len, *range_length - os->written_len);
     os->written_len = 0;
-    av_free(buffer);
+    if (out_buf)
+        *out_buf = buffer;
+    else
+        av_free(buffer);
 
     // re-open buffer
     return avio_open_dyn_buf(&os->ctx->pb);
@@ -395,7 +700,7 @@ static int flush_init_segment(AVFormatContext *s, OutputStream *os)
     DASHContext *c = s->priv_data;
     int ret, range_length;
 
-    ret = flush_dynbuf(os, &range_length);
+    ret = flush_dynbuf(os, &range_length, NULL);
     if (ret < 0)
         return ret;
 
@@ -413,6 +718,11 @@ static void dash_free(AVFormatContext *s)
     DASHContext *c = s->priv_data;
     int i, j;
 
+#if HAVE_THREADS
+    /* only still running if muxing was aborted before the trailer */
+    stop_upload_thread(s, 1);
+#endif
+
     if (c->as) {
         for (i = 0; i < c->nb_as; i++)
             av_dict_free(&c->as[i].metadata);
@@ -462,6 +772,10 @@ static void output_segment_list(OutputStream *os, AVIOContext *out, AVFormatCont
             if (c->streaming && os->availability_time_offset)
                 avio_printf(out, "availabilityTimeOffset=\"%.3f\" ",
                             os->availability_time_offset);
+            /* only chunked segments can be fetched before they are complete */
+            if (c->streaming && os->availability_time_offset &&
+                c->frag_duration && c->frag_duration < c->seg_duration)
+                avio_printf(out, "availabilityTimeComplete=\"false\" ");
         }
         avio_printf(out, "initialization=\"%s\" media=\"%s\" startNumber=\"%d\">\n", os->init_seg_name, os->media_seg_name, c->use_timeline ? start_number : 1);
         if (c->use_timeline) {
@@ -527,7 +841,7 @@ static void output_segment_list(OutputStream *os, AVIOContext *out, AVFormatCont
         snprintf(temp_filename_hls, sizeof(temp_filename_hls), use_rename ? "%s.tmp" : "%s", filename_hls);
 
         set_http_options(&http_opts, c);
-        dashenc_io_open(s, &c->m3u8_out, temp_filename_hls, &http_opts);
+        dashenc_output_open(s, &c->m3u8_out, temp_filename_hls, &http_opts);
         av_dict_free(&http_opts);
         for (i = start_index; i < os->nb_segments; i++) {
             Segment *seg = os->segments[i];
@@ -557,12 +871,13 @@ static void output_segment_list(OutputStream *os, AVIOContext *out, AVFormatCont
         if (final)
             ff_hls_write_end_list(c->m3u8_out);
 
-        dashenc_io_close(s, &c->m3u8_out, temp_filename_hls);
-
-        if (use_rename)
-            if (avpriv_io_move(temp_filename_hls, filename_hls) < 0) {
+        if (dashenc_output_close(s, &c->m3u8_out, temp_filename_hls,
+                                 use_rename ? filename_hls : NULL) < 0) {
+            if (c->async_upload)
+                av_log(os->ctx, AV_LOG_WARNING, "queuing upload of %s failed\n", filename_hls);
+            else
                 av_log(os->ctx, AV_LOG_WARNING, "renaming file %s to %s failed\n\n", temp_filename_hls, filename_hls);
-            }
+        }
     }
 
 }
@@ -838,7 +1153,7 @@ static int write_manifest(AVFormatContext *s, int final)
 
     snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", s->url);
     set_http_options(&opts, c);
-    ret = dashenc_io_open(s, &c->mpd_out, temp_filename, &opts);
+    ret = dashenc_output_open(s, &c->mpd_out, temp_filename, &opts);
     av_dict_free(&opts);
     if (ret < 0) {
         av_log(s, AV_LOG_ERROR, "Unable to open %s for writing\n", temp_filename);
@@ -907,12 +1222,9 @@ static int write_manifest(AVFormatContext *s, int final)
 
     avio_printf(out, "</MPD>\n");
     avio_flush(out);
-    dashenc_io_close(s, &c->mpd_out, temp_filename);
-
-    if (use_rename) {
-        if ((ret = avpriv_io_move(temp_filename, s->url)) < 0)
-            return ret;
-    }
+    if ((ret = dashenc_output_close(s, &c->mpd_out, temp_filename,
+                                    use_rename ? s->url : NULL)) < 0)
+        return ret;
 
     if (c->hls_playlist && !c->master_playlist_created) {
         char filename_hls[1024];
@@ -929,7 +1241,7 @@ static int write_manifest(AVFormatContext *s, int final)
         snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", filename_hls);
 
         set_http_options(&opts, c);
-        ret = dashenc_io_open(s, &c->m3u8_out, temp_filename, &opts);
+        ret = dashenc_output_open(s, &c->m3u8_out, temp_filename, &opts);
         av_dict_free(&opts);
         if (ret < 0) {
             av_log(s, AV_LOG_ERROR, "Unable to open %s for writing\n", temp_filename);
@@ -982,10 +1294,9 @@ static int write_manifest(AVFormatContext *s, int final)
                                      playlist_file, agroup,
                                      codec_str_ptr, NULL);
         }
-        dashenc_io_close(s, &c->m3u8_out, temp_filename);
-        if (use_rename)
-            if ((ret = avpriv_io_move(temp_filename, filename_hls)) < 0)
-                return ret;
+        if ((ret = dashenc_output_close(s, &c->m3u8_out, temp_filename,
+                                        use_rename ? filename_hls : NULL)) < 0)
+            return ret;
         c->master_playlist_created = 1;
     }
 
@@ -1012,6 +1323,20 @@ static int dash_init(AVFormatContext *s)
     if (c->single_file)
         c->use_template = 0;
 
+    if (c->async_upload) {
+        if (c->single_file || c->streaming) {
+            av_log(s, AV_LOG_ERROR, "async_upload cannot be used with single_file or streaming\n");
+            return AVERROR(EINVAL);
+        }
+#if HAVE_THREADS
+        if ((ret = start_upload_thread(s)) < 0)
+            return ret;
+#else
+        av_log(s, AV_LOG_ERROR, "async_upload requires threading support\n");
+        return AVERROR(ENOSYS);
+#endif
+    }
+
 #if FF_API_DASH_MIN_SEG_DURATION
     if (c->min_seg_duration != 5000000) {
         av_log(s, AV_LOG_WARNING, "The min_seg_duration option is deprecated and will be removed. Please use the -seg_duration\n");
@@ -1140,10 +1465,14 @@ static int dash_init(AVFormatContext *s)
         }
 
         if (os->segment_type == SEGMENT_TYPE_MP4) {
-            if (c->streaming)
+            if (c->streaming && !c->frag_duration)
                 av_dict_set(&opts, "movflags", "frag_every_frame+dash+delay_moov+global_sidx", 0);
+            else if (c->streaming)
+                av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov+global_sidx", 0);
             else
                 av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov", 0);
+            if (c->frag_duration)
+                av_dict_set_int(&opts, "frag_duration", c->frag_duration, 0);
         } else {
             av_dict_set_int(&opts, "cluster_time_limit", c->seg_duration / 1000, 0);
             av_dict_set_int(&opts, "cluster_size_limit", 5 * 1024 * 1024, 0); // set a large cluster size limit
@@ -1359,6 +1688,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         OutputStream *os = &c->streams[i];
         AVStream *st = s->streams[i];
         int range_length, index_length = 0;
+        uint8_t *buffer = NULL;
 
         if (!os->packets_written)
             continue;
@@ -1382,13 +1712,18 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
             snprintf(os->full_path, sizeof(os->full_path), "%s%s", c->dirname, os->initfile);
         }
 
-        ret = flush_dynbuf(os, &range_length);
+        ret = flush_dynbuf(os, &range_length, c->async_upload ? &buffer : NULL);
         if (ret < 0)
             break;
         os->packets_written = 0;
 
         if (c->single_file) {
             find_index_range(s, os->full_path, os->pos, &index_length);
+        } else if (c->async_upload) {
+            ret = queue_upload(s, os->temp_path, use_rename ? os->full_path : NULL,
+                               buffer, range_length, 0);
+            if (ret < 0)
+                break;
         } else {
             dashenc_io_close(s, &os->out, os->temp_path);
 
@@ -1431,7 +1766,11 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
                 for (j = 0; j < remove; j++) {
                     char filename[1024];
                     snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->segments[j]->file);
-                    dashenc_delete_file(s, filename);
+                    if (c->async_upload) {
+                        if (ret >= 0)
+                            ret = queue_upload(s, filename, NULL, NULL, 0, 1);
+                    } else
+                        dashenc_delete_file(s, filename);
                     av_free(os->segments[j]);
                 }
                 os->nb_segments -= remove;
@@ -1483,7 +1822,15 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
         format_date_now(c->availability_start_time,
                         sizeof(c->availability_start_time));
 
-    if (!os->availability_time_offset && pkt->duration) {
+    /* A chunk is available as soon as it has been written. Chunks are single
+     * frames without frag_duration, and whole segments if frag_duration is
+     * not shorter than a segment, which leaves no offset to advertise. */
+    if (!os->availability_time_offset && c->frag_duration &&
+        c->frag_duration < c->seg_duration) {
+        os->availability_time_offset = ((double) c->seg_duration -
+                                        c->frag_duration) / AV_TIME_BASE;
+    } else if (!os->availability_time_offset && !c->frag_duration &&
+               pkt->duration) {
         int64_t frame_duration = av_rescale_q(pkt->duration, st->time_base,
                                               AV_TIME_BASE_Q);
          os->availability_time_offset = ((double) c->seg_duration -
@@ -1558,11 +1905,13 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
                  os->filename);
         snprintf(os->temp_path, sizeof(os->temp_path),
                  use_rename ? "%s.tmp" : "%s", os->full_path);
-        set_http_options(&opts, c);
-        ret = dashenc_io_open(s, &os->out, os->temp_path, &opts);
-        av_dict_free(&opts);
-        if (ret < 0)
-            return ret;
+        if (!c->async_upload) {
+            set_http_options(&opts, c);
+            ret = dashenc_io_open(s, &os->out, os->temp_path, &opts);
+            av_dict_free(&opts);
+            if (ret < 0)
+                return ret;
+        }
     }
 
     //write out the data immediately in streaming mode
@@ -1584,6 +1933,7 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
 static int dash_write_trailer(AVFormatContext *s)
 {
     DASHContext *c = s->priv_data;
+    int ret = 0;
 
     if (s->nb_streams > 0) {
         OutputStream *os = &c->streams[0];
@@ -1599,6 +1949,12 @@ static int dash_write_trailer(AVFormatContext *s)
     }
     dash_flush(s, 1, -1);
 
+#if HAVE_THREADS
+    /* Segments and manifests must be in place before files are removed. */
+    if ((ret = stop_upload_thread(s, 0)) < 0)
+        av_log(s, AV_LOG_ERROR, "Uploading failed: %s\n", av_err2str(ret));
+#endif
+
     if (c->remove_at_exit) {
         char filename[1024];
         int i;
@@ -1610,7 +1966,7 @@ static int dash_write_trailer(AVFormatContext *s)
         dashenc_delete_file(s, s->url);
     }
 
-    return 0;
+    return ret;
 }
 
 static int dash_check_bitstream(struct AVFormatContext *s, const AVPacket *avpkt)
@@ -1659,9 +2015,12 @@ static const AVOption options[] = {
     { "http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
     { "hls_playlist", "Generate HLS playlist files(master.m3u8, media_%d.m3u8)", OFFSET(hls_playlist), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "streaming", "Enable/Disable streaming mode of output. Each frame will be moof fragment", OFFSET(streaming), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "frag_duration", "fragment (chunk) duration within a segment (in seconds, fractional value can be set)", OFFSET(frag_duration), AV_OPT_TYPE_DURATION, { .i64 = 0 }, 0, INT_MAX, E },
     { "timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     { "index_correction", "Enable/Disable segment index correction logic", OFFSET(index_correction), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "format_options","set list of options for the container format (mp4/webm) used for dash", OFFSET(format_options_str), AV_OPT_TYPE_STRING, {.str = NULL},  0, 0, E},
+    { "async_upload", "Write segments and manifests from a background thread", OFFSET(async_upload), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "upload_queue_size", "Maximum number of pending uploads before muxing blocks", OFFSET(upload_queue_size), AV_OPT_TYPE_INT, { .i64 = 8 }, 1, INT_MAX, E },
     { "dash_segment_type", "set dash segment files type", OFFSET(segment_type_option), AV_OPT_TYPE_INT, {.i64 = SEGMENT_TYPE_AUTO }, 0, SEGMENT_TYPE_NB - 1, E, "segment_type"},
     { "auto", "select segment file format based on codec", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_AUTO }, 0, UINT_MAX,   E, "segment_type"},
     { "mp4", "make segment file in ISOBMFF format", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_MP4 }, 0, UINT_MAX,   E, "segment_type"},
@@ -1644,7 +1644,8 @@ static int save_avio_options(AVFormatContext *s)
 {
     HLSContext *c = s->priv_data;
     static const char * const opts[] = {
-        "headers", "http_proxy", "user_agent", "cookies", "referer", "rw_timeout", NULL };
+        "headers", "http_proxy", "user_agent", "cookies", "referer", "rw_timeout",
+        "connection_pool", NULL };
     const char * const * opt = opts;
     uint8_t *buf;
     int ret = 0;
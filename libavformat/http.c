@@ -27,9 +27,11 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/bprint.h"
 #include "libavutil/opt.h"
 #include "libavutil/time.h"
 #include "libavutil/parseutils.h"
+#include "libavutil/thread.h"
 
 #include "avformat.h"
 #include "http.h"
@@ -50,6 +52,8 @@
 #define HTTP_SINGLE   1
 #define HTTP_MUTLI    2
 #define MAX_EXPIRY    19
+#define POOL_MAX_CONNECTIONS 16
+#define POOL_IDLE_TIMEOUT    (10 * 1000000)
 #define WHITESPACES " \n\t\r"
 typedef enum {
     LOWER_PROTO,
@@ -58,6 +62,21 @@ typedef enum {
     FINISH
 }HandshakeState;
 
+/* A lower-level connection that can be handed over between HTTP contexts.
+ * The connection is opened with an interrupt callback forwarding to the
+ * one of its current owner, so that it never refers to a closed context. */
+typedef struct HTTPPoolConnection {
+    URLContext *hd;
+    char *key;
+    AVIOInterruptCB owner_cb;
+    int64_t idle_since;
+    struct HTTPPoolConnection *next;
+} HTTPPoolConnection;
+
+static AVMutex pool_mutex = AV_MUTEX_INITIALIZER;
+static HTTPPoolConnection *pool;
+static int pool_size;
+
 typedef struct HTTPContext {
     const AVClass *class;
     URLContext *hd;
@@ -68,12 +87,15 @@ typedef struct HTTPContext {
     uint64_t chunksize;
     int chunkend;
     uint64_t off, end_off, filesize;
+    uint64_t content_length, body_end;
     char *location;
     HTTPAuthState auth_state;
     HTTPAuthState proxy_auth_state;
     char *http_proxy;
     char *headers;
     char *mime_type;
+    char *etag;
+    char *last_modified;
     char *http_version;
     char *user_agent;
     char *referer;
@@ -125,6 +147,8 @@ typedef struct HTTPContext {
     int is_multi_client;
     HandshakeState handshake_step;
     int is_connected_server;
+    int connection_pool;
+    HTTPPoolConnection *pool_conn;
 } HTTPContext;
 
 #define OFFSET(x) offsetof(HTTPContext, x)
@@ -144,9 +168,12 @@ static const AVOption options[] = {
     { "user-agent", "use the \"user_agent\" option instead", OFFSET(user_agent_deprecated), AV_OPT_TYPE_STRING, { .str = DEFAULT_USER_AGENT }, 0, 0, D|AV_OPT_FLAG_DEPRECATED },
 #endif
     { "multiple_requests", "use persistent connections", OFFSET(multiple_requests), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, D | E },
+    { "connection_pool", "reuse idle keep-alive connections across requests", OFFSET(connection_pool), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, D },
     { "post_data", "set custom HTTP post data", OFFSET(post_data), AV_OPT_TYPE_BINARY, .flags = D | E },
     { "mime_type", "export the MIME type", OFFSET(mime_type), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { "http_version", "export the http response version", OFFSET(http_version), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "etag", "export the ETag of the resource", OFFSET(etag), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "last_modified", "export the Last-Modified date of the resource", OFFSET(last_modified), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { "cookies", "set cookies to be sent in applicable future requests, use newline delimited Set-Cookie HTTP field value syntax", OFFSET(cookies), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, D },
     { "icy", "request ICY metadata", OFFSET(icy), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, D },
     { "icy_metadata_headers", "return ICY metadata headers", OFFSET(icy_metadata_headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, AV_OPT_FLAG_EXPORT },
@@ -186,6 +213,239 @@ void ff_http_init_auth_state(URLContext *dest, const URLContext *src)
            sizeof(HTTPAuthState));
 }
 
+static int pool_interrupt_cb(void *opaque)
+{
+    HTTPPoolConnection *c = opaque;
+    return c->owner_cb.callback ? c->owner_cb.callback(c->owner_cb.opaque) : 0;
+}
+
+static void pool_conn_free(HTTPPoolConnection **pc)
+{
+    HTTPPoolConnection *c = *pc;
+
+    if (!c)
+        return;
+    ffurl_closep(&c->hd);
+    av_freep(&c->key);
+    av_freep(pc);
+}
+
+/* Connections are only shared with the same lower url, proxy, timeouts,
+ * custom headers and TLS settings. */
+static char *pool_key(HTTPContext *s, const char *url, const char *proxy,
+                      AVDictionary *options)
+{
+    static const char * const conn_opts[] = {
+        "timeout", "rw_timeout", NULL
+    };
+    static const char * const tls_opts[] = {
+        "ca_file", "cafile", "tls_verify", "cert_file", "key_file", NULL
+    };
+    AVBPrint bp;
+    char *key;
+    int i;
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprintf(&bp, "%s|%s|%s", url, proxy ? proxy : "",
+               s->headers ? s->headers : "");
+    for (i = 0; conn_opts[i]; i++) {
+        AVDictionaryEntry *e = av_dict_get(options, conn_opts[i], NULL, 0);
+        av_bprintf(&bp, "|%s", e ? e->value : "");
+    }
+    if (av_strstart(url, "tls:", NULL)) {
+        for (i = 0; tls_opts[i]; i++) {
+            AVDictionaryEntry *e = av_dict_get(options, tls_opts[i], NULL, 0);
+            av_bprintf(&bp, "|%s", e ? e->value : "");
+        }
+    }
+    if (!av_bprint_is_complete(&bp)) {
+        av_bprint_finalize(&bp, NULL);
+        return NULL;
+    }
+    if (av_bprint_finalize(&bp, &key) < 0)
+        return NULL;
+    return key;
+}
+
+/* Unlink the connections idle for longer than max_idle; pool_mutex must be
+ * held. They are returned as a list, to be closed without the lock. */
+static HTTPPoolConnection *pool_unlink_idle(int64_t max_idle)
+{
+    HTTPPoolConnection **pc, *c, *expired = NULL;
+    int64_t now = av_gettime_relative();
+
+    for (pc = &pool; (c = *pc); ) {
+        if (now - c->idle_since >= max_idle) {
+            *pc = c->next;
+            c->next = expired;
+            expired = c;
+            pool_size--;
+        } else {
+            pc = &c->next;
+        }
+    }
+    return expired;
+}
+
+static void pool_free_list(HTTPPoolConnection *c)
+{
+    HTTPPoolConnection *next;
+
+    for (; c; c = next) {
+        next = c->next;
+        pool_conn_free(&c);
+    }
+}
+
+static HTTPPoolConnection *pool_get(const char *key)
+{
+    HTTPPoolConnection **pc, *c, *found = NULL, *expired;
+
+    ff_mutex_lock(&pool_mutex);
+    expired = pool_unlink_idle(POOL_IDLE_TIMEOUT);
+    for (pc = &pool; (c = *pc); ) {
+        if (!strcmp(c->key, key)) {
+            *pc = c->next;
+            c->next = NULL;
+            found = c;
+            pool_size--;
+            break;
+        } else {
+            pc = &c->next;
+        }
+    }
+    ff_mutex_unlock(&pool_mutex);
+
+    pool_free_list(expired);
+    return found;
+}
+
+static void pool_put(HTTPPoolConnection *c)
+{
+    HTTPPoolConnection **pc, *evicted = NULL, *expired;
+
+    c->owner_cb   = (AVIOInterruptCB) { NULL, NULL };
+    c->idle_since = av_gettime_relative();
+
+    ff_mutex_lock(&pool_mutex);
+    expired = pool_unlink_idle(POOL_IDLE_TIMEOUT);
+    c->next = pool;
+    pool = c;
+    if (++pool_size > POOL_MAX_CONNECTIONS) {
+        for (pc = &pool; (*pc)->next; pc = &(*pc)->next)
+            ;
+        evicted = *pc;
+        *pc = NULL;
+        pool_size--;
+    }
+    ff_mutex_unlock(&pool_mutex);
+
+    pool_conn_free(&evicted);
+    pool_free_list(expired);
+}
+
+void ff_http_pool_close(void)
+{
+    HTTPPoolConnection *idle;
+
+    ff_mutex_lock(&pool_mutex);
+    idle = pool_unlink_idle(0);
+    ff_mutex_unlock(&pool_mutex);
+
+    pool_free_list(idle);
+}
+
+static void close_connection(HTTPContext *s)
+{
+    if (s->pool_conn) {
+        s->pool_conn->hd = NULL;
+        pool_conn_free(&s->pool_conn);
+    }
+    ffurl_closep(&s->hd);
+}
+
+/* Return true if the current response has been read completely and the
+ * server keeps the connection open for another request. */
+static int connection_reusable(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+
+    if (!s->hd || !s->pool_conn || s->willclose ||
+        (h->flags & AVIO_FLAG_WRITE) || s->post_data ||
+        s->http_code / 100 != 2 || s->buf_ptr != s->buf_end)
+        return 0;
+    if (s->chunksize != UINT64_MAX)
+        return s->chunkend;
+    return s->body_end != UINT64_MAX && s->off == s->body_end;
+}
+
+static void release_connection(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+
+    if (connection_reusable(h)) {
+        av_log(h, AV_LOG_DEBUG, "Returning connection to the pool\n");
+        pool_put(s->pool_conn);
+        s->pool_conn = NULL;
+        s->hd        = NULL;
+    } else {
+        close_connection(s);
+    }
+}
+
+static int open_lower(URLContext *h, const char *url, const char *proxy,
+                      AVDictionary **options, int use_pool, int *reused)
+{
+    HTTPContext *s = h->priv_data;
+    HTTPPoolConnection *c = NULL;
+    AVIOInterruptCB cb;
+    char *key;
+    int err;
+
+    if (!s->connection_pool)
+        return ffurl_open_whitelist(&s->hd, url, AVIO_FLAG_READ_WRITE,
+                                    &h->interrupt_callback, options,
+                                    h->protocol_whitelist, h->protocol_blacklist, h);
+
+    if (!(key = pool_key(s, url, proxy, *options)))
+        return AVERROR(ENOMEM);
+    if (use_pool)
+        c = pool_get(key);
+    if (c) {
+        av_log(h, AV_LOG_DEBUG, "Reusing pooled connection to %s\n", url);
+        av_free(key);
+        *reused = 1;
+    } else {
+        if (!(c = av_mallocz(sizeof(*c)))) {
+            av_free(key);
+            return AVERROR(ENOMEM);
+        }
+        c->key = key;
+        cb = (AVIOInterruptCB) { pool_interrupt_cb, c };
+        c->owner_cb = h->interrupt_callback;
+        err = ffurl_open_whitelist(&c->hd, url, AVIO_FLAG_READ_WRITE,
+                                   &cb, options,
+                                   h->protocol_whitelist, h->protocol_blacklist, h);
+        if (err < 0) {
+            pool_conn_free(&c);
+            return err;
+        }
+    }
+    c->owner_cb  = h->interrupt_callback;
+    s->pool_conn = c;
+    s->hd        = c->hd;
+    return 0;
+}
+
+static int request_is_idempotent(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+
+    if (s->method)
+        return !av_strcasecmp(s->method, "GET") || !av_strcasecmp(s->method, "HEAD");
+    return !(h->flags & AVIO_FLAG_WRITE) && !s->post_data;
+}
+
 static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
 {
     const char *path, *proxy_path, *lower_proto = "tcp", *local_path;
@@ -193,8 +453,9 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     char auth[1024], proxyauth[1024] = "";
     char path1[MAX_URL_SIZE];
     char buf[1024], urlbuf[MAX_URL_SIZE];
-    int port, use_proxy, err, location_changed = 0;
+    int port, use_proxy, err, location_changed = 0, reused = 0;
     HTTPContext *s = h->priv_data;
+    uint64_t off = s->off;
 
     av_url_split(proto, sizeof(proto), auth, sizeof(auth),
                  hostname, sizeof(hostname), &port,
@@ -232,15 +493,26 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     ff_url_join(buf, sizeof(buf), lower_proto, NULL, hostname, port, NULL);
 
     if (!s->hd) {
-        err = ffurl_open_whitelist(&s->hd, buf, AVIO_FLAG_READ_WRITE,
-                                   &h->interrupt_callback, options,
-                                   h->protocol_whitelist, h->protocol_blacklist, h);
+        err = open_lower(h, buf, use_proxy ? proxy_path : NULL, options, 1, &reused);
         if (err < 0)
             return err;
     }
 
     err = http_connect(h, path, local_path, hoststr,
                        auth, proxyauth, &location_changed);
+    /* The server may have closed the idle connection meanwhile. Only GET
+     * and HEAD requests are retried, since the failed request may have
+     * reached the server. */
+    if (err < 0 && reused && err != AVERROR_EXIT &&
+        request_is_idempotent(h)) {
+        close_connection(s);
+        s->off = off;
+        location_changed = 0;
+        if ((err = open_lower(h, buf, use_proxy ? proxy_path : NULL, options, 0, &reused)) < 0)
+            return err;
+        err = http_connect(h, path, local_path, hoststr,
+                           auth, proxyauth, &location_changed);
+    }
     if (err < 0)
         return err;
 
@@ -267,7 +539,7 @@ redo:
     if (s->http_code == 401) {
         if ((cur_auth_type == HTTP_AUTH_NONE || s->auth_state.stale) &&
             s->auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_closep(&s->hd);
+            close_connection(s);
             goto redo;
         } else
             goto fail;
@@ -275,7 +547,7 @@ redo:
     if (s->http_code == 407) {
         if ((cur_proxy_auth_type == HTTP_AUTH_NONE || s->proxy_auth_state.stale) &&
             s->proxy_auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_closep(&s->hd);
+            close_connection(s);
             goto redo;
         } else
             goto fail;
@@ -284,7 +556,7 @@ redo:
          s->http_code == 303 || s->http_code == 307) &&
         location_changed == 1) {
         /* url moved, get next */
-        ffurl_closep(&s->hd);
+        close_connection(s);
         if (redirects++ >= MAX_REDIRECTS)
             return AVERROR(EIO);
         /* Restart the authentication process with the new target, which
@@ -298,7 +570,7 @@ redo:
 
 fail:
     if (s->hd)
-        ffurl_closep(&s->hd);
+        close_connection(s);
     if (location_changed < 0)
         return location_changed;
     return ff_http_averror(s->http_code, AVERROR(EIO));
@@ -969,9 +1241,10 @@ static int process_line(URLContext *h, char *line, int line_count,
             if ((ret = parse_location(s, p)) < 0)
                 return ret;
             *new_location = 1;
-        } else if (!av_strcasecmp(tag, "Content-Length") &&
-                   s->filesize == UINT64_MAX) {
-            s->filesize = strtoull(p, NULL, 10);
+        } else if (!av_strcasecmp(tag, "Content-Length")) {
+            s->content_length = strtoull(p, NULL, 10);
+            if (s->filesize == UINT64_MAX)
+                s->filesize = s->content_length;
         } else if (!av_strcasecmp(tag, "Content-Range")) {
             parse_content_range(h, p);
         } else if (!av_strcasecmp(tag, "Accept-Ranges") &&
@@ -997,6 +1270,12 @@ static int process_line(URLContext *h, char *line, int line_count,
             } else if (!av_strncasecmp(p, "MediaGateway", 12)) {
                 s->is_mediagateway = 1;
             }
+        } else if (!av_strcasecmp(tag, "ETag")) {
+            av_free(s->etag);
+            s->etag = av_strdup(p);
+        } else if (!av_strcasecmp(tag, "Last-Modified")) {
+            av_free(s->last_modified);
+            s->last_modified = av_strdup(p);
         } else if (!av_strcasecmp(tag, "Content-Type")) {
             av_free(s->mime_type);
             s->mime_type = av_strdup(p);
@@ -1139,6 +1418,9 @@ static int http_read_header(URLContext *h, int *new_location)
     if (s->seekable == -1 && s->is_mediagateway && s->filesize == 2000000000)
         h->is_streamed = 1; /* we can in fact _not_ seek */
 
+    if (s->content_length != UINT64_MAX)
+        s->body_end = s->off + s->content_length;
+
     // add any new cookies into the existing cookie string
     cookie_string(s->cookie_dict, &s->cookies);
     av_dict_free(&s->cookie_dict);
@@ -1226,7 +1508,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
                            "Expect: 100-continue\r\n");
 
     if (!has_header(s->headers, "\r\nConnection: ")) {
-        if (s->multiple_requests)
+        if (s->multiple_requests || s->connection_pool)
             len += av_strlcpy(headers + len, "Connection: keep-alive\r\n",
                               sizeof(headers) - len);
         else
@@ -1298,6 +1580,8 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
     s->off              = 0;
     s->icy_data_read    = 0;
     s->filesize         = UINT64_MAX;
+    s->content_length   = UINT64_MAX;
+    s->body_end         = UINT64_MAX;
     s->willclose        = 0;
     s->end_chunked_post = 0;
     s->end_header       = 0;
@@ -1352,7 +1636,7 @@ static int http_buf_read(URLContext *h, uint8_t *buf, int size)
                    "Chunked encoding data size: %"PRIu64"\n",
                     s->chunksize);
 
-            if (!s->chunksize && s->multiple_requests) {
+            if (!s->chunksize && (s->multiple_requests || s->connection_pool)) {
                 http_get_line(s, line, sizeof(line)); // read empty chunk
                 s->chunkend = 1;
                 return 0;
@@ -1655,7 +1939,7 @@ static int http_close(URLContext *h)
         ret = http_shutdown(h, h->flags);
 
     if (s->hd)
-        ffurl_closep(&s->hd);
+        release_connection(h);
     av_dict_free(&s->chained_options);
     return ret;
 }
@@ -1664,7 +1948,9 @@ static int64_t http_seek_internal(URLContext *h, int64_t off, int whence, int fo
 {
     HTTPContext *s = h->priv_data;
     URLContext *old_hd = s->hd;
+    HTTPPoolConnection *old_pool_conn = s->pool_conn;
     uint64_t old_off = s->off;
+    int old_reusable;
     uint8_t old_buf[BUFFER_SIZE];
     int old_buf_size, ret;
     AVDictionary *options = NULL;
@@ -1694,7 +1980,11 @@ static int64_t http_seek_internal(URLContext *h, int64_t off, int whence, int fo
     /* we save the old context in case the seek fails */
     old_buf_size = s->buf_end - s->buf_ptr;
     memcpy(old_buf, s->buf_ptr, old_buf_size);
+    s->off = old_off;
+    old_reusable = connection_reusable(h);
+    s->off = off;
     s->hd = NULL;
+    s->pool_conn = NULL;
 
     /* if it fails, continue on old connection */
     if ((ret = http_open_cnx(h, &options)) < 0) {
@@ -1703,11 +1993,19 @@ static int64_t http_seek_internal(URLContext *h, int64_t off, int whence, int fo
         s->buf_ptr = s->buffer;
         s->buf_end = s->buffer + old_buf_size;
         s->hd      = old_hd;
+        s->pool_conn = old_pool_conn;
         s->off     = old_off;
         return ret;
     }
     av_dict_free(&options);
-    ffurl_close(old_hd);
+    if (old_pool_conn && old_reusable) {
+        pool_put(old_pool_conn);
+    } else {
+        if (old_pool_conn)
+            old_pool_conn->hd = NULL;
+        pool_conn_free(&old_pool_conn);
+        ffurl_close(old_hd);
+    }
     return off;
 }
 
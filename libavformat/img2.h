@@ -61,6 +61,8 @@ typedef struct VideoDemuxData {
     int start_number_range;
     int frame_size;
     int ts_from_file;
+    int read_ahead;         /**< number of files read in advance, set by a private option */
+    struct ImgReadAhead *ra;
 } VideoDemuxData;
 
 typedef struct IdStrMap {
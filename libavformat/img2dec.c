@@ -29,6 +29,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/intreadwrite.h"
+#include "libavutil/thread.h"
 #include "avformat.h"
 #include "avio_internal.h"
 #include "internal.h"
@@ -372,6 +373,276 @@ int ff_img_read_header(AVFormatContext *s1)
     return 0;
 }
 
+#if HAVE_THREADS
+enum ImgReadSlotState {
+    SLOT_FREE,
+    SLOT_QUEUED,
+    SLOT_BUSY,
+    SLOT_DONE,
+};
+
+typedef struct ImgReadSlot {
+    char filename[1024];
+    int number;
+    enum ImgReadSlotState state;
+    uint8_t *data;
+    int size;
+    int ret;
+} ImgReadSlot;
+
+/* Ring of slots holding the next images in sequence order; worker threads
+ * fill them in any order, the demuxer consumes them from head. */
+typedef struct ImgReadAhead {
+    AVFormatContext *s1;
+    ImgReadSlot *slots;
+    int nb_slots;
+    int head;
+    int nb_used;
+    int next_number;
+    pthread_t *threads;
+    int nb_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int stop;
+} ImgReadAhead;
+
+static int read_whole_file(AVFormatContext *s1, ImgReadSlot *slot)
+{
+    AVIOContext *pb = NULL;
+    int64_t size;
+    int ret;
+
+    /* s1->io_open is not used here: it may not be thread-safe */
+    ret = ffio_open_whitelist(&pb, slot->filename, AVIO_FLAG_READ,
+                              &s1->interrupt_callback, NULL,
+                              s1->protocol_whitelist, s1->protocol_blacklist);
+    if (ret < 0)
+        return ret;
+    size = avio_size(pb);
+    if (size < 0 || size > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE) {
+        ret = size < 0 ? size : AVERROR(ERANGE);
+        goto end;
+    }
+    slot->data = av_malloc(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!slot->data) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    ret = avio_read(pb, slot->data, size);
+    if (ret == 0)
+        ret = AVERROR_INVALIDDATA; /* an empty file is not an image */
+    if (ret > 0) {
+        slot->size = ret;
+        memset(slot->data + ret, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    }
+end:
+    avio_closep(&pb);
+    return ret;
+}
+
+static void *read_ahead_worker(void *arg)
+{
+    ImgReadAhead *ra = arg;
+    ImgReadSlot *slot;
+    int i, ret;
+
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->stop) {
+        slot = NULL;
+        for (i = 0; i < ra->nb_used; i++) {
+            ImgReadSlot *cur = &ra->slots[(ra->head + i) % ra->nb_slots];
+            if (cur->state == SLOT_QUEUED) {
+                slot = cur;
+                break;
+            }
+        }
+        if (!slot) {
+            pthread_cond_wait(&ra->cond, &ra->lock);
+            continue;
+        }
+        slot->state = SLOT_BUSY;
+        pthread_mutex_unlock(&ra->lock);
+
+        ret = read_whole_file(ra->s1, slot);
+
+        pthread_mutex_lock(&ra->lock);
+        slot->ret   = ret;
+        slot->state = SLOT_DONE;
+        pthread_cond_broadcast(&ra->cond);
+    }
+    pthread_mutex_unlock(&ra->lock);
+    return NULL;
+}
+
+static void read_ahead_free(VideoDemuxData *s)
+{
+    ImgReadAhead *ra = s->ra;
+    int i;
+
+    if (!ra)
+        return;
+    pthread_mutex_lock(&ra->lock);
+    ra->stop = 1;
+    pthread_cond_broadcast(&ra->cond);
+    pthread_mutex_unlock(&ra->lock);
+    for (i = 0; i < ra->nb_threads; i++)
+        pthread_join(ra->threads[i], NULL);
+    for (i = 0; i < ra->nb_slots; i++)
+        av_freep(&ra->slots[i].data);
+    pthread_cond_destroy(&ra->cond);
+    pthread_mutex_destroy(&ra->lock);
+    av_freep(&ra->threads);
+    av_freep(&ra->slots);
+    av_freep(&s->ra);
+}
+
+static int read_ahead_init(AVFormatContext *s1)
+{
+    VideoDemuxData *s = s1->priv_data;
+    ImgReadAhead *ra;
+    int i, ret;
+
+    ra = s->ra = av_mallocz(sizeof(*ra));
+    if (!ra)
+        return AVERROR(ENOMEM);
+    ra->s1       = s1;
+    ra->nb_slots = s->read_ahead;
+    ra->slots    = av_mallocz_array(ra->nb_slots, sizeof(*ra->slots));
+    ra->threads  = av_mallocz_array(ra->nb_slots, sizeof(*ra->threads));
+    if (!ra->slots || !ra->threads) {
+        av_freep(&ra->slots);
+        av_freep(&ra->threads);
+        av_freep(&s->ra);
+        return AVERROR(ENOMEM);
+    }
+    ra->next_number = s->img_number;
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->cond, NULL);
+    for (i = 0; i < ra->nb_slots; i++) {
+        ret = pthread_create(&ra->threads[i], NULL, read_ahead_worker, ra);
+        if (ret) {
+            av_log(s1, AV_LOG_ERROR, "Could not create read-ahead thread: %s\n",
+                   av_err2str(AVERROR(ret)));
+            read_ahead_free(s);
+            return AVERROR(ret);
+        }
+        ra->nb_threads++;
+    }
+    return 0;
+}
+
+/* Drop all queued images, waiting for the ones being read. */
+static void read_ahead_flush(ImgReadAhead *ra, int next_number)
+{
+    int i;
+
+    for (i = 0; i < ra->nb_slots; i++) {
+        while (ra->slots[i].state == SLOT_BUSY)
+            pthread_cond_wait(&ra->cond, &ra->lock);
+        av_freep(&ra->slots[i].data);
+        ra->slots[i].state = SLOT_FREE;
+    }
+    ra->head        = 0;
+    ra->nb_used     = 0;
+    ra->next_number = next_number;
+}
+
+static int read_ahead_packet(AVFormatContext *s1, AVPacket *pkt)
+{
+    VideoDemuxData *s = s1->priv_data;
+    AVCodecParameters *par = s1->streams[0]->codecpar;
+    ImgReadAhead *ra = s->ra;
+    ImgReadSlot *slot;
+    int ret;
+
+    if (s->loop && s->img_number > s->img_last)
+        s->img_number = s->img_first;
+    if (s->img_number > s->img_last)
+        return AVERROR_EOF;
+
+    pthread_mutex_lock(&ra->lock);
+    if (ra->nb_used && ra->slots[ra->head].number != s->img_number)
+        read_ahead_flush(ra, s->img_number);
+    if (!ra->nb_used)
+        ra->next_number = s->img_number;
+    while (ra->nb_used < ra->nb_slots) {
+        if (s->loop && ra->next_number > s->img_last)
+            ra->next_number = s->img_first;
+        if (ra->next_number > s->img_last)
+            break;
+        slot = &ra->slots[(ra->head + ra->nb_used) % ra->nb_slots];
+        if (s->use_glob) {
+#if HAVE_GLOB
+            av_strlcpy(slot->filename, s->globstate.gl_pathv[ra->next_number],
+                       sizeof(slot->filename));
+#endif
+        } else if (av_get_frame_filename(slot->filename, sizeof(slot->filename),
+                                         s->path, ra->next_number) < 0 &&
+                   ra->next_number > 1) {
+            if (!ra->nb_used) {
+                pthread_mutex_unlock(&ra->lock);
+                return AVERROR(EINVAL);
+            }
+            break;
+        }
+        slot->number = ra->next_number++;
+        slot->size   = 0;
+        slot->ret    = 0;
+        slot->state  = SLOT_QUEUED;
+        ra->nb_used++;
+    }
+    pthread_cond_broadcast(&ra->cond);
+
+    slot = &ra->slots[ra->head];
+    while (slot->state != SLOT_DONE)
+        pthread_cond_wait(&ra->cond, &ra->lock);
+    pthread_mutex_unlock(&ra->lock);
+
+    if (slot->ret < 0) {
+        av_log(s1, AV_LOG_ERROR, "Could not read file : %s\n", slot->filename);
+        return slot->ret;
+    }
+
+    if (par->codec_id == AV_CODEC_ID_NONE) {
+        AVProbeData pd = { 0 };
+        AVInputFormat *ifmt;
+        uint8_t header[PROBE_BUF_MIN + AVPROBE_PADDING_SIZE] = { 0 };
+        int score = 0;
+
+        pd.buf      = header;
+        pd.buf_size = FFMIN(slot->size, PROBE_BUF_MIN);
+        pd.filename = slot->filename;
+        memcpy(header, slot->data, pd.buf_size);
+
+        ifmt = av_probe_input_format3(&pd, 1, &score);
+        if (ifmt && ifmt->read_packet == ff_img_read_packet && ifmt->raw_codec_id)
+            par->codec_id = ifmt->raw_codec_id;
+    }
+    if (par->codec_id == AV_CODEC_ID_RAWVIDEO && !par->width)
+        infer_size(&par->width, &par->height, slot->size);
+
+    ret = av_packet_from_data(pkt, slot->data, slot->size);
+    if (ret < 0)
+        return ret;
+    slot->data = NULL;
+
+    pkt->stream_index = 0;
+    pkt->flags       |= AV_PKT_FLAG_KEY;
+    pkt->pts          = s->pts;
+
+    pthread_mutex_lock(&ra->lock);
+    slot->state = SLOT_FREE;
+    ra->head    = (ra->head + 1) % ra->nb_slots;
+    ra->nb_used--;
+    pthread_mutex_unlock(&ra->lock);
+
+    s->img_count++;
+    s->img_number++;
+    s->pts++;
+    return 0;
+}
+#endif
+
 int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
 {
     VideoDemuxData *s = s1->priv_data;
@@ -382,6 +653,16 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
     AVIOContext *f[3]     = { NULL };
     AVCodecParameters *par = s1->streams[0]->codecpar;
 
+#if HAVE_THREADS
+    if (s->read_ahead > 0 && !s->ra && !s->is_pipe && !s1->pb &&
+        s->pattern_type != PT_NONE && !s->split_planes && !s->ts_from_file) {
+        if ((res = read_ahead_init(s1)) < 0)
+            return res;
+    }
+    if (s->ra)
+        return read_ahead_packet(s1, pkt);
+#endif
+
     if (!s->is_pipe) {
         /* loop over input */
         if (s->loop && s->img_number > s->img_last) {
@@ -399,7 +680,7 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
         if (av_get_frame_filename(filename_bytes, sizeof(filename_bytes),
                                   s->path,
                                   s->img_number) < 0 && s->img_number > 1)
-            return AVERROR(EIO);
+            return AVERROR(EINVAL);
         }
         for (i = 0; i < 3; i++) {
             if (s1->pb &&
@@ -407,12 +688,12 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
                 !s->loop &&
                 !s->split_planes) {
                 f[i] = s1->pb;
-            } else if (s1->io_open(s1, &f[i], filename, AVIO_FLAG_READ, NULL) < 0) {
+            } else if ((res = s1->io_open(s1, &f[i], filename, AVIO_FLAG_READ, NULL)) < 0) {
                 if (i >= 1)
                     break;
                 av_log(s1, AV_LOG_ERROR, "Could not open file : %s\n",
                        filename);
-                return AVERROR(EIO);
+                return res;
             }
             size[i] = avio_size(f[i]);
 
@@ -532,8 +813,11 @@ fail:
 
 static int img_read_close(struct AVFormatContext* s1)
 {
-#if HAVE_GLOB
     VideoDemuxData *s = s1->priv_data;
+#if HAVE_THREADS
+    read_ahead_free(s);
+#endif
+#if HAVE_GLOB
     if (s->use_glob) {
         globfree(&s->globstate);
     }
@@ -582,6 +866,7 @@ const AVOption ff_img_options[] = {
     { "none", "none",                   0, AV_OPT_TYPE_CONST,    {.i64 = 0   }, 0, 2,       DEC, "ts_type" },
     { "sec",  "second precision",       0, AV_OPT_TYPE_CONST,    {.i64 = 1   }, 0, 2,       DEC, "ts_type" },
     { "ns",   "nano second precision",  0, AV_OPT_TYPE_CONST,    {.i64 = 2   }, 0, 2,       DEC, "ts_type" },
+    { "read_ahead",   "number of files to open and read in parallel", OFFSET(read_ahead), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, 256, DEC },
     { NULL },
 };
 
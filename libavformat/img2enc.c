@@ -26,6 +26,7 @@
 #include "libavutil/log.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 #include "libavutil/time_internal.h"
 #include "avformat.h"
 #include "avio_internal.h"
@@ -45,8 +46,163 @@ typedef struct VideoMuxData {
     int frame_pts;
     const char *muxer;
     int use_rename;
+    int write_threads;
+#if HAVE_THREADS
+    struct ImgWriteJob *jobs;
+    int nb_jobs;
+    int job_head;
+    int nb_queued;
+    pthread_t *threads;
+    int nb_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int stop;
+    int write_error;
+#endif
 } VideoMuxData;
 
+#if HAVE_THREADS
+typedef struct ImgWriteJob {
+    char filename[1024];
+    char target[1024];
+    AVPacket pkt;
+} ImgWriteJob;
+
+static int write_job(AVFormatContext *s, ImgWriteJob *job)
+{
+    AVIOContext *pb = NULL;
+    int ret;
+
+    /* s->io_open is not used here: it may not be thread-safe */
+    ret = ffio_open_whitelist(&pb, job->filename, AVIO_FLAG_WRITE,
+                              &s->interrupt_callback, NULL,
+                              s->protocol_whitelist, s->protocol_blacklist);
+    if (ret < 0) {
+        av_log(s, AV_LOG_ERROR, "Could not open file : %s\n", job->filename);
+        return ret;
+    }
+    avio_write(pb, job->pkt.data, job->pkt.size);
+    avio_flush(pb);
+    ret = pb->error;
+    avio_closep(&pb);
+    if (ret >= 0 && job->target[0])
+        ret = ff_rename(job->filename, job->target, s);
+    return ret;
+}
+
+static void *write_worker(void *arg)
+{
+    AVFormatContext *s = arg;
+    VideoMuxData *img = s->priv_data;
+    ImgWriteJob job;
+    int ret;
+
+    pthread_mutex_lock(&img->lock);
+    while (1) {
+        if (!img->nb_queued) {
+            if (img->stop)
+                break;
+            pthread_cond_wait(&img->cond, &img->lock);
+            continue;
+        }
+        job = img->jobs[img->job_head];
+        memset(&img->jobs[img->job_head].pkt, 0, sizeof(job.pkt));
+        img->job_head = (img->job_head + 1) % img->nb_jobs;
+        img->nb_queued--;
+        pthread_cond_broadcast(&img->cond);
+        pthread_mutex_unlock(&img->lock);
+
+        ret = write_job(s, &job);
+        av_packet_unref(&job.pkt);
+
+        pthread_mutex_lock(&img->lock);
+        if (ret < 0 && !img->write_error)
+            img->write_error = ret;
+    }
+    pthread_mutex_unlock(&img->lock);
+    return NULL;
+}
+
+static int start_write_threads(AVFormatContext *s)
+{
+    VideoMuxData *img = s->priv_data;
+    int i, ret;
+
+    img->nb_jobs = 2 * img->write_threads;
+    img->jobs    = av_mallocz_array(img->nb_jobs, sizeof(*img->jobs));
+    img->threads = av_mallocz_array(img->write_threads, sizeof(*img->threads));
+    if (!img->jobs || !img->threads) {
+        av_freep(&img->jobs);
+        av_freep(&img->threads);
+        return AVERROR(ENOMEM);
+    }
+    pthread_mutex_init(&img->lock, NULL);
+    pthread_cond_init(&img->cond, NULL);
+    for (i = 0; i < img->write_threads; i++) {
+        ret = pthread_create(&img->threads[i], NULL, write_worker, s);
+        if (ret) {
+            av_log(s, AV_LOG_ERROR, "Could not create write thread: %s\n",
+                   av_err2str(AVERROR(ret)));
+            return AVERROR(ret);
+        }
+        img->nb_threads++;
+    }
+    return 0;
+}
+
+/* Wait until all queued images are written and stop the threads. */
+static int stop_write_threads(AVFormatContext *s)
+{
+    VideoMuxData *img = s->priv_data;
+    int i;
+
+    if (!img->threads)
+        return 0;
+    pthread_mutex_lock(&img->lock);
+    img->stop = 1;
+    pthread_cond_broadcast(&img->cond);
+    pthread_mutex_unlock(&img->lock);
+    for (i = 0; i < img->nb_threads; i++)
+        pthread_join(img->threads[i], NULL);
+    for (i = 0; i < img->nb_jobs; i++)
+        av_packet_unref(&img->jobs[i].pkt);
+    pthread_cond_destroy(&img->cond);
+    pthread_mutex_destroy(&img->lock);
+    av_freep(&img->threads);
+    av_freep(&img->jobs);
+    img->nb_threads = 0;
+    return img->write_error;
+}
+
+static int queue_write(AVFormatContext *s, const char *filename, AVPacket *pkt)
+{
+    VideoMuxData *img = s->priv_data;
+    ImgWriteJob *job;
+    int ret;
+
+    pthread_mutex_lock(&img->lock);
+    while (img->nb_queued == img->nb_jobs && !img->write_error)
+        pthread_cond_wait(&img->cond, &img->lock);
+    if ((ret = img->write_error) < 0)
+        goto end;
+    job = &img->jobs[(img->job_head + img->nb_queued) % img->nb_jobs];
+    if ((ret = av_packet_ref(&job->pkt, pkt)) < 0)
+        goto end;
+    if (img->use_rename) {
+        snprintf(job->filename, sizeof(job->filename), "%s.tmp", filename);
+        av_strlcpy(job->target, filename, sizeof(job->target));
+    } else {
+        av_strlcpy(job->filename, filename, sizeof(job->filename));
+        job->target[0] = 0;
+    }
+    img->nb_queued++;
+    pthread_cond_broadcast(&img->cond);
+end:
+    pthread_mutex_unlock(&img->lock);
+    return ret;
+}
+#endif
+
 static int write_header(AVFormatContext *s)
 {
     VideoMuxData *img = s->priv_data;
@@ -75,6 +231,12 @@ static int write_header(AVFormatContext *s)
                              && desc->nb_components >= 3;
     }
 
+#if HAVE_THREADS
+    if (img->write_threads > 0 && !img->is_pipe && !img->split_planes &&
+        !img->muxer && !img->update && !img->use_strftime && !img->frame_pts)
+        return start_write_threads(s);
+#endif
+
     return 0;
 }
 
@@ -85,7 +247,7 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
     char filename[1024];
     AVCodecParameters *par = s->streams[pkt->stream_index]->codecpar;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(par->format);
-    int i;
+    int i, ret;
     int nb_renames = 0;
 
     if (!img->is_pipe) {
@@ -114,12 +276,21 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
                    img->img_number, img->path);
             return AVERROR(EINVAL);
         }
+#if HAVE_THREADS
+        if (img->threads) {
+            ret = queue_write(s, filename, pkt);
+            if (ret < 0)
+                return ret;
+            img->img_number++;
+            return 0;
+        }
+#endif
         for (i = 0; i < 4; i++) {
             snprintf(img->tmp[i], sizeof(img->tmp[i]), "%s.tmp", filename);
             av_strlcpy(img->target[i], filename, sizeof(img->target[i]));
-            if (s->io_open(s, &pb[i], img->use_rename ? img->tmp[i] : filename, AVIO_FLAG_WRITE, NULL) < 0) {
+            if ((ret = s->io_open(s, &pb[i], img->use_rename ? img->tmp[i] : filename, AVIO_FLAG_WRITE, NULL)) < 0) {
                 av_log(s, AV_LOG_ERROR, "Could not open file : %s\n", img->use_rename ? img->tmp[i] : filename);
-                return AVERROR(EIO);
+                return ret;
             }
 
             if (!img->split_planes || i+1 >= desc->nb_components)
@@ -149,7 +320,6 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
             ff_format_io_close(s, &pb[3]);
         }
     } else if (img->muxer) {
-        int ret;
         AVStream *st;
         AVPacket pkt2 = {0};
         AVFormatContext *fmt = NULL;
@@ -185,7 +355,7 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
     if (!img->is_pipe) {
         ff_format_io_close(s, &pb[0]);
         for (i = 0; i < nb_renames; i++) {
-            int ret = ff_rename(img->tmp[i], img->target[i], s);
+            ret = ff_rename(img->tmp[i], img->target[i], s);
             if (ret < 0)
                 return ret;
         }
@@ -195,6 +365,18 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
     return 0;
 }
 
+#if HAVE_THREADS
+static int write_trailer(AVFormatContext *s)
+{
+    return stop_write_threads(s);
+}
+
+static void img_deinit(AVFormatContext *s)
+{
+    stop_write_threads(s);
+}
+#endif
+
 static int query_codec(enum AVCodecID id, int std_compliance)
 {
     int i;
@@ -214,6 +396,7 @@ static const AVOption muxoptions[] = {
     { "strftime",     "use strftime for filename", OFFSET(use_strftime),  AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
     { "frame_pts",    "use current frame pts for filename", OFFSET(frame_pts),  AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
     { "atomic_writing", "write files atomically (using temporary files and renames)", OFFSET(use_rename), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
+    { "write_threads", "number of files to write in parallel", OFFSET(write_threads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 256, ENC },
     { NULL },
 };
 
@@ -235,6 +418,10 @@ AVOutputFormat ff_image2_muxer = {
     .video_codec    = AV_CODEC_ID_MJPEG,
     .write_header   = write_header,
     .write_packet   = write_packet,
+#if HAVE_THREADS
+    .write_trailer  = write_trailer,
+    .deinit         = img_deinit,
+#endif
     .query_codec    = query_codec,
     .flags          = AVFMT_NOTIMESTAMPS | AVFMT_NODIMENSIONS | AVFMT_NOFILE,
     .priv_class     = &img2mux_class,
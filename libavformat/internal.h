@@ -144,6 +144,12 @@ struct AVFormatInternal {
      * Prefer the codec framerate for avg_frame_rate computation.
      */
     int prefer_codec_framerate;
+
+    /**
+     * Worker threads running trial decodes during
+     * avformat_find_stream_info(), NULL when probing serially.
+     */
+    struct StreamInfoThreads *stream_info_threads;
 };
 
 struct AVStreamInternal {
@@ -99,6 +99,7 @@ typedef const struct EbmlSyntax {
 
 typedef struct EbmlList {
     int nb_elem;
+    unsigned int alloc_elem_size;
     void *elem;
 } EbmlList;
 
@@ -1178,7 +1179,10 @@ static int ebml_parse_elem(MatroskaDemuxContext *matroska,
     data = (char *) data + syntax->data_offset;
     if (syntax->list_elem_size) {
         EbmlList *list = data;
-        newelem = av_realloc_array(list->elem, list->nb_elem + 1, syntax->list_elem_size);
+        if ((unsigned)list->nb_elem + 1 >= UINT_MAX / syntax->list_elem_size)
+            return AVERROR(ENOMEM);
+        newelem = av_fast_realloc(list->elem, &list->alloc_elem_size,
+                                  (list->nb_elem + 1) * syntax->list_elem_size);
         if (!newelem)
             return AVERROR(ENOMEM);
         list->elem = newelem;
@@ -1270,6 +1274,7 @@ static void ebml_free(EbmlSyntax *syntax, void *data)
                     ebml_free(syntax[i].def.n, ptr);
                 av_freep(&list->elem);
                 list->nb_elem = 0;
+                list->alloc_elem_size = 0;
             } else
                 ebml_free(syntax[i].def.n, data_off);
         default:
@@ -3494,6 +3499,15 @@ static int matroska_parse_cluster_incremental(MatroskaDemuxContext *matroska)
                                        matroska->current_cluster_pos,
                                        blocks[i].discard_padding);
         }
+        /* The packets hold their own references to the block data, so
+         * drop the block right away instead of keeping every block of the
+         * cluster around. Earlier entries can be left over from a failed
+         * parse, free them too. The list allocation is kept and reused for
+         * the next block. */
+        for (i = 0; i < blocks_list->nb_elem; i++)
+            ebml_free(matroska_blockgroup, &blocks[i]);
+        blocks_list->nb_elem                 = 0;
+        matroska->current_cluster_num_blocks = 0;
     }
 
     return res;
@@ -46,7 +46,6 @@
 typedef struct MOVIentry {
     uint64_t     pos;
     int64_t      dts;
-    int64_t      pts;
     unsigned int size;
     unsigned int samples_in_chunk;
     unsigned int chunkNum;              ///< Chunk number if the current entry is a chunk start otherwise 0
@@ -111,6 +110,7 @@ typedef struct MOVTrack {
     uint8_t     *vos_data;
     MOVIentry   *cluster;
     unsigned    cluster_capacity;
+    int64_t     cluster_first_pts; ///< original pts of cluster[0]
     int         audio_vbr;
     int         height; ///< active picture (w/o VBI) height for D-10/IMX
     uint32_t    tref_tag;
@@ -157,6 +157,17 @@ struct MpegTSContext {
     unsigned int nb_prg;
     struct Program *prg;
 
+    /** cached discard_pid() results: 0 unknown, 1 keep, 2 discard */
+    uint8_t discard_cache[NB_PID_MAX];
+    int discard_cache_dirty;
+    /** AVProgram.discard values the cache was computed for */
+    enum AVDiscard *discard_snapshot;
+    int nb_discard_snapshot;
+    /** set if any AVProgram had AVDISCARD_ALL at the last check */
+    int any_discarded;
+    /** packets left until the AVProgram.discard values are checked again */
+    int discard_rescan;
+
     int8_t crc_validity[NB_PID_MAX];
     /** filters for various streams specified by PMT + for the PAT and PMT */
     MpegTSFilter *pids[NB_PID_MAX];
@@ -288,12 +299,14 @@ static void clear_program(MpegTSContext *ts, unsigned int programid)
             ts->prg[i].nb_pids = 0;
             ts->prg[i].pmt_found = 0;
         }
+    ts->discard_cache_dirty = 1;
 }
 
 static void clear_programs(MpegTSContext *ts)
 {
     av_freep(&ts->prg);
     ts->nb_prg = 0;
+    ts->discard_cache_dirty = 1;
 }
 
 static void add_pat_entry(MpegTSContext *ts, unsigned int programid)
@@ -308,6 +321,7 @@ static void add_pat_entry(MpegTSContext *ts, unsigned int programid)
     p->nb_pids = 0;
     p->pmt_found = 0;
     ts->nb_prg++;
+    ts->discard_cache_dirty = 1;
 }
 
 static void add_pid_to_pmt(MpegTSContext *ts, unsigned int programid,
@@ -326,6 +340,7 @@ static void add_pid_to_pmt(MpegTSContext *ts, unsigned int programid,
             return;
 
     p->pids[p->nb_pids++] = pid;
+    ts->discard_cache_dirty = 1;
 }
 
 static void set_pmt_found(MpegTSContext *ts, unsigned int programid)
@@ -359,6 +374,38 @@ static void update_av_program_info(AVFormatContext *s, unsigned int programid,
     }
 }
 
+/* The AVProgram.discard values are only checked at this packet interval
+ * and when the program tables change, not on every packet. */
+#define DISCARD_RESCAN_INTERVAL 1024
+
+static void update_discard_snapshot(MpegTSContext *ts)
+{
+    AVFormatContext *s = ts->stream;
+    int k;
+
+    if (s->nb_programs != ts->nb_discard_snapshot) {
+        if (av_reallocp_array(&ts->discard_snapshot, s->nb_programs,
+                              sizeof(*ts->discard_snapshot)) < 0)
+            ts->nb_discard_snapshot = 0;
+        else
+            ts->nb_discard_snapshot = s->nb_programs;
+        for (k = 0; k < ts->nb_discard_snapshot; k++)
+            ts->discard_snapshot[k] = AVDISCARD_NONE - 1;
+    }
+
+    ts->any_discarded = 0;
+    for (k = 0; k < s->nb_programs; k++) {
+        enum AVDiscard discard = s->programs[k]->discard;
+        if (k < ts->nb_discard_snapshot && ts->discard_snapshot[k] != discard) {
+            ts->discard_snapshot[k] = discard;
+            ts->discard_cache_dirty = 1;
+        }
+        if (discard == AVDISCARD_ALL)
+            ts->any_discarded = 1;
+    }
+    ts->discard_rescan = DISCARD_RESCAN_INTERVAL;
+}
+
 /**
  * @brief discard_pid() decides if the pid is to be discarded according
  *                      to caller's programs selection
@@ -369,18 +416,29 @@ static void update_av_program_info(AVFormatContext *s, unsigned int programid,
  */
 static int discard_pid(MpegTSContext *ts, unsigned int pid)
 {
+    AVFormatContext *s = ts->stream;
     int i, j, k;
     int used = 0, discarded = 0;
     struct Program *p;
 
+    /* The result only depends on the program tables and on the discard
+     * settings of the AVPrograms. Cache it per PID and drop the cache
+     * whenever either changes. */
+    if (ts->discard_cache_dirty || --ts->discard_rescan <= 0)
+        update_discard_snapshot(ts);
+    if (ts->discard_cache_dirty) {
+        memset(ts->discard_cache, 0, sizeof(ts->discard_cache));
+        ts->discard_cache_dirty = 0;
+    }
+
     /* If none of the programs have .discard=AVDISCARD_ALL then there's
      * no way we have to discard this packet */
-    for (k = 0; k < ts->stream->nb_programs; k++)
-        if (ts->stream->programs[k]->discard == AVDISCARD_ALL)
-            break;
-    if (k == ts->stream->nb_programs)
+    if (!ts->any_discarded)
         return 0;
 
+    if (ts->discard_cache[pid] && ts->nb_discard_snapshot == s->nb_programs)
+        return ts->discard_cache[pid] - 1;
+
     for (i = 0; i < ts->nb_prg; i++) {
         p = &ts->prg[i];
         for (j = 0; j < p->nb_pids; j++) {
@@ -398,6 +456,7 @@ static int discard_pid(MpegTSContext *ts, unsigned int pid)
         }
     }
 
+    ts->discard_cache[pid] = 1 + (!used && discarded);
     return !used && discarded;
 }
 
@@ -3015,6 +3074,8 @@ static void mpegts_free(MpegTSContext *ts)
     int i;
 
     clear_programs(ts);
+    av_freep(&ts->discard_snapshot);
+    ts->nb_discard_snapshot = 0;
 
     for (i = 0; i < NB_PID_MAX; i++)
         if (ts->pids[i])
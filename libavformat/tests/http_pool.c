@@ -0,0 +1,202 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Runs requests with the connection_pool option of the http protocol
+ * against a keep-alive server on the loopback interface, and prints how
+ * many connections the server has seen.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/log.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+#include "libavformat/network.h"
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int nb_connections, nb_open, nb_requests;
+
+static void *serve_connection(void *arg)
+{
+    int fd = (intptr_t)arg;
+    static const char reply[] = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+    char buf[4096];
+    int len = 0;
+
+    for (;;) {
+        char *end;
+        int ret = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (ret <= 0)
+            break;
+        len += ret;
+        buf[len] = 0;
+        if (!(end = strstr(buf, "\r\n\r\n"))) {
+            if (len == sizeof(buf) - 1)
+                break;
+            continue;
+        }
+
+        pthread_mutex_lock(&lock);
+        nb_requests++;
+        pthread_mutex_unlock(&lock);
+        if (send(fd, reply, sizeof(reply) - 1, 0) < 0)
+            break;
+        /* close idle connections behind the client's back */
+        if (strstr(buf, " /close "))
+            break;
+        len -= end + 4 - buf;
+        memmove(buf, end + 4, len);
+    }
+
+    closesocket(fd);
+    pthread_mutex_lock(&lock);
+    nb_open--;
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+static void *serve(void *arg)
+{
+    int listen_fd = (intptr_t)arg;
+
+    for (;;) {
+        pthread_t thread;
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+            break;
+        pthread_mutex_lock(&lock);
+        nb_connections++;
+        nb_open++;
+        pthread_mutex_unlock(&lock);
+        if (pthread_create(&thread, NULL, serve_connection, (void *)(intptr_t)fd)) {
+            closesocket(fd);
+            break;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+static int fetch(const char *url, const char *method, const char *headers,
+                 int pool)
+{
+    AVIOContext *pb = NULL;
+    AVDictionary *opts = NULL;
+    unsigned char buf[16];
+    int ret, size = 0;
+
+    av_dict_set_int(&opts, "connection_pool", pool, 0);
+    if (method)
+        av_dict_set(&opts, "method", method, 0);
+    if (headers)
+        av_dict_set(&opts, "headers", headers, 0);
+    ret = avio_open2(&pb, url, AVIO_FLAG_READ, NULL, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+    while ((ret = avio_read(pb, buf, sizeof(buf))) > 0)
+        size += ret;
+    avio_closep(&pb);
+    return size;
+}
+
+/* wait until the server has processed the closing of the connections */
+static int open_connections(int expected)
+{
+    int64_t start = av_gettime_relative();
+    int n;
+
+    do {
+        pthread_mutex_lock(&lock);
+        n = nb_open;
+        pthread_mutex_unlock(&lock);
+        if (n == expected)
+            break;
+        av_usleep(1000);
+    } while (av_gettime_relative() - start < 5000000);
+    return n;
+}
+
+static void report(const char *test, int ret)
+{
+    pthread_mutex_lock(&lock);
+    printf("%-32s %-6s requests %d, connections %d\n", test,
+           ret == 5 ? "ok" : "error", nb_requests, nb_connections);
+    pthread_mutex_unlock(&lock);
+}
+
+int main(void)
+{
+    struct sockaddr_in addr = { 0 };
+    socklen_t addrlen = sizeof(addr);
+    char url[64], close_url[80];
+    pthread_t server;
+    int listen_fd, i, ret;
+
+    av_log_set_level(AV_LOG_QUIET);
+    avformat_network_init();
+
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listen_fd = ff_socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0 ||
+        bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(listen_fd, 8) ||
+        getsockname(listen_fd, (struct sockaddr *)&addr, &addrlen)) {
+        fprintf(stderr, "Cannot listen on the loopback interface\n");
+        return 1;
+    }
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/", ntohs(addr.sin_port));
+    snprintf(close_url, sizeof(close_url), "%s%s", url, "close");
+    if (pthread_create(&server, NULL, serve, (void *)(intptr_t)listen_fd))
+        return 1;
+
+    for (i = 0; i < 3; i++)
+        ret = fetch(url, NULL, NULL, 1);
+    report("3 GET, pooled", ret);
+
+    ret = fetch(url, NULL, "X-Test: 1\r\n", 1);
+    report("GET, other headers", ret);
+
+    /* the pooled connection of the first requests is closed by the server,
+     * the one with other headers stays open */
+    fetch(close_url, NULL, NULL, 1);
+    open_connections(1);
+    ret = fetch(url, NULL, NULL, 1);
+    report("GET, stale connection", ret);
+
+    /* not retried, as it may have reached the server */
+    fetch(close_url, NULL, NULL, 1);
+    open_connections(1);
+    ret = fetch(url, "DELETE", NULL, 1);
+    report("DELETE, stale, not retried", ret);
+
+    for (i = 0; i < 2; i++)
+        ret = fetch(url, NULL, NULL, 0);
+    report("2 GET, not pooled", ret);
+
+    printf("idle connections: %d\n", open_connections(1));
+    avformat_network_deinit();
+    printf("idle connections after deinit: %d\n", open_connections(0));
+
+    return 0;
+}
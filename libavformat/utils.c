@@ -26,6 +26,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/cpu.h"
 #include "libavutil/dict.h"
 #include "libavutil/internal.h"
 #include "libavutil/mathematics.h"
@@ -46,6 +47,7 @@
 #include "avio_internal.h"
 #include "id3v2.h"
 #include "internal.h"
+#include "http.h"
 #include "metadata.h"
 #if CONFIG_NETWORK
 #include "network.h"
@@ -1567,6 +1569,8 @@ static int64_t ts_to_samples(AVStream *st, int64_t ts)
     return av_rescale(ts, st->time_base.num * st->codecpar->sample_rate, st->time_base.den);
 }
 
+static void stream_info_threads_wait(AVFormatContext *ic, int stream_index);
+
 static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
 {
     int ret = 0, i, got_packet = 0;
@@ -1583,6 +1587,8 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
         if (ret < 0) {
             if (ret == AVERROR(EAGAIN))
                 return ret;
+            /* the parsers share the codec contexts with pending decodes */
+            stream_info_threads_wait(s, -1);
             /* flush the parsers */
             for (i = 0; i < s->nb_streams; i++) {
                 st = s->streams[i];
@@ -1596,6 +1602,8 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
         ret = 0;
         st  = s->streams[cur_pkt.stream_index];
 
+        stream_info_threads_wait(s, st->index);
+
         /* update context if required */
         if (st->internal->need_context_update) {
             if (avcodec_is_open(st->internal->avctx)) {
@@ -3111,6 +3119,255 @@ fail:
     return ret;
 }
 
+#if HAVE_THREADS
+typedef struct StreamInfoJob {
+    AVStream *st;
+    AVPacket pkt;
+    AVDictionary **options;
+    int flush;
+    int busy;                   ///< queued or being decoded by a worker
+} StreamInfoJob;
+
+typedef struct StreamInfoThreads {
+    AVFormatContext *ic;
+    pthread_t *workers;
+    int nb_workers;
+
+    /* one job slot per stream present when the threads were started */
+    StreamInfoJob *jobs;
+    int nb_jobs;
+    int *queue;                 ///< FIFO of stream indexes with a pending job
+    int queue_head;
+    int queue_count;
+    int exit;
+
+    pthread_mutex_t lock;
+    pthread_cond_t job_cond;
+    pthread_cond_t done_cond;
+} StreamInfoThreads;
+
+static void stream_info_run_job(AVFormatContext *ic, StreamInfoJob *job)
+{
+    AVStream *st = job->st;
+    int err;
+
+    if (!job->flush) {
+        try_decode_frame(ic, st, &job->pkt, job->options);
+        av_packet_unref(&job->pkt);
+        st->codec_info_nb_frames++;
+        return;
+    }
+
+    do {
+        err = try_decode_frame(ic, st, &job->pkt, job->options);
+    } while (err > 0 && !has_codec_parameters(st, NULL));
+
+    if (err < 0)
+        av_log(ic, AV_LOG_INFO, "decoding for stream %d failed\n", st->index);
+}
+
+static void *stream_info_worker(void *arg)
+{
+    StreamInfoThreads *t = arg;
+
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        StreamInfoJob *job;
+
+        while (!t->queue_count && !t->exit)
+            pthread_cond_wait(&t->job_cond, &t->lock);
+        if (!t->queue_count)
+            break;
+
+        job = &t->jobs[t->queue[t->queue_head]];
+        t->queue_head = (t->queue_head + 1) % t->nb_jobs;
+        t->queue_count--;
+        pthread_mutex_unlock(&t->lock);
+
+        stream_info_run_job(t->ic, job);
+
+        pthread_mutex_lock(&t->lock);
+        job->busy = 0;
+        pthread_cond_broadcast(&t->done_cond);
+    }
+    pthread_mutex_unlock(&t->lock);
+
+    return NULL;
+}
+
+static void stream_info_threads_free(AVFormatContext *ic)
+{
+    StreamInfoThreads *t = ic->internal->stream_info_threads;
+    int i;
+
+    if (!t)
+        return;
+
+    pthread_mutex_lock(&t->lock);
+    t->exit = 1;
+    pthread_cond_broadcast(&t->job_cond);
+    pthread_mutex_unlock(&t->lock);
+
+    for (i = 0; i < t->nb_workers; i++)
+        pthread_join(t->workers[i], NULL);
+
+    for (i = 0; i < t->nb_jobs; i++)
+        av_packet_unref(&t->jobs[i].pkt);
+
+    pthread_cond_destroy(&t->done_cond);
+    pthread_cond_destroy(&t->job_cond);
+    pthread_mutex_destroy(&t->lock);
+    av_freep(&t->workers);
+    av_freep(&t->jobs);
+    av_freep(&t->queue);
+    av_freep(&ic->internal->stream_info_threads);
+}
+
+static int stream_info_threads_init(AVFormatContext *ic, int nb_workers)
+{
+    StreamInfoThreads *t;
+    int i, ret;
+
+    if (!nb_workers)
+        nb_workers = av_cpu_count();
+    nb_workers = FFMIN(nb_workers, ic->nb_streams);
+    if (nb_workers <= 1)
+        return 0;
+
+    t = av_mallocz(sizeof(*t));
+    if (!t)
+        return AVERROR(ENOMEM);
+    ic->internal->stream_info_threads = t;
+
+    t->ic      = ic;
+    t->nb_jobs = ic->nb_streams;
+    t->jobs    = av_mallocz_array(t->nb_jobs, sizeof(*t->jobs));
+    t->queue   = av_malloc_array(t->nb_jobs, sizeof(*t->queue));
+    t->workers = av_malloc_array(nb_workers, sizeof(*t->workers));
+    if (!t->jobs || !t->queue || !t->workers) {
+        av_freep(&t->jobs);
+        av_freep(&t->queue);
+        av_freep(&t->workers);
+        av_freep(&ic->internal->stream_info_threads);
+        return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < t->nb_jobs; i++) {
+        t->jobs[i].st = ic->streams[i];
+        av_init_packet(&t->jobs[i].pkt);
+        t->jobs[i].pkt.data = NULL;
+        t->jobs[i].pkt.size = 0;
+    }
+
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->job_cond, NULL);
+    pthread_cond_init(&t->done_cond, NULL);
+
+    for (i = 0; i < nb_workers; i++) {
+        ret = pthread_create(&t->workers[i], NULL, stream_info_worker, t);
+        if (ret) {
+            av_log(ic, AV_LOG_WARNING, "Failed to create stream info thread: %s, "
+                   "probing with %d threads\n", av_err2str(AVERROR(ret)), i);
+            break;
+        }
+        t->nb_workers++;
+    }
+    if (!t->nb_workers)
+        stream_info_threads_free(ic);
+
+    return 0;
+}
+
+/* Returns 1 if the stream has no decode in flight and may be accessed. */
+static int stream_info_threads_idle(AVFormatContext *ic, int stream_index)
+{
+    StreamInfoThreads *t = ic->internal->stream_info_threads;
+    int busy;
+
+    if (!t || stream_index >= t->nb_jobs)
+        return 1;
+
+    pthread_mutex_lock(&t->lock);
+    busy = t->jobs[stream_index].busy;
+    pthread_mutex_unlock(&t->lock);
+
+    return !busy;
+}
+
+static void stream_info_threads_wait(AVFormatContext *ic, int stream_index)
+{
+    StreamInfoThreads *t = ic->internal->stream_info_threads;
+    int i;
+
+    if (!t)
+        return;
+
+    pthread_mutex_lock(&t->lock);
+    for (i = 0; i < t->nb_jobs; i++) {
+        if (stream_index >= 0 && i != stream_index)
+            continue;
+        while (t->jobs[i].busy)
+            pthread_cond_wait(&t->done_cond, &t->lock);
+    }
+    pthread_mutex_unlock(&t->lock);
+}
+
+/**
+ * Queue a trial decode of pkt, or a decoder flush if pkt is NULL, on the
+ * worker threads. The stream must be idle.
+ *
+ * @return 1 if the job was queued, 0 if the caller must decode by itself,
+ *         a negative error code on failure
+ */
+static int stream_info_threads_submit(AVFormatContext *ic, AVStream *st,
+                                      AVPacket *pkt, AVDictionary **options)
+{
+    StreamInfoThreads *t = ic->internal->stream_info_threads;
+    StreamInfoJob *job;
+    int ret;
+
+    if (!t || st->index >= t->nb_jobs)
+        return 0;
+
+    job = &t->jobs[st->index];
+    job->options = options;
+    job->flush   = !pkt;
+    if (pkt && (ret = av_packet_ref(&job->pkt, pkt)) < 0)
+        return ret;
+
+    pthread_mutex_lock(&t->lock);
+    job->busy = 1;
+    t->queue[(t->queue_head + t->queue_count++) % t->nb_jobs] = st->index;
+    pthread_cond_signal(&t->job_cond);
+    pthread_mutex_unlock(&t->lock);
+
+    return 1;
+}
+#else
+static void stream_info_threads_free(AVFormatContext *ic)
+{
+}
+
+static int stream_info_threads_init(AVFormatContext *ic, int nb_workers)
+{
+    return 0;
+}
+
+static int stream_info_threads_idle(AVFormatContext *ic, int stream_index)
+{
+    return 1;
+}
+
+static void stream_info_threads_wait(AVFormatContext *ic, int stream_index)
+{
+}
+
+static int stream_info_threads_submit(AVFormatContext *ic, AVStream *st,
+                                      AVPacket *pkt, AVDictionary **options)
+{
+    return 0;
+}
+#endif
+
 unsigned int ff_codec_get_tag(const AVCodecTag *tags, enum AVCodecID id)
 {
     while (tags->id != AV_CODEC_ID_NONE) {
@@ -3684,6 +3941,12 @@ FF_ENABLE_DEPRECATION_WARNINGS
         ic->streams[i]->info->fps_last_dts  = AV_NOPTS_VALUE;
     }
 
+    if (ic->stream_info_threads != 1) {
+        ret = stream_info_threads_init(ic, ic->stream_info_threads);
+        if (ret < 0)
+            goto find_stream_info_err;
+    }
+
     read_size = 0;
     for (;;) {
         int analyzed_all_streams;
@@ -3699,6 +3962,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
             int count;
 
             st = ic->streams[i];
+            /* a decode still in flight may provide the missing info */
+            if (!stream_info_threads_idle(ic, i))
+                break;
             if (!has_codec_parameters(st, NULL))
                 break;
             /* If the timebase is coarse (like the usual millisecond precision
@@ -3781,6 +4047,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
         pkt = &pkt1;
 
+        /* packets queued by the parser skip the wait in read_frame_internal() */
+        stream_info_threads_wait(ic, pkt->stream_index);
+
         if (!(ic->flags & AVFMT_FLAG_NOBUFFER)) {
             ret = ff_packet_list_put(&ic->internal->packet_buffer,
                                      &ic->internal->packet_buffer_end,
@@ -3897,16 +4166,24 @@ FF_ENABLE_DEPRECATION_WARNINGS
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
          * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+        ret = stream_info_threads_submit(ic, st, pkt,
+                                         (options && st->index < orig_nb_streams) ? &options[st->index] : NULL);
+        if (ret < 0)
+            goto find_stream_info_err;
+        if (!ret) {
+            try_decode_frame(ic, st, pkt,
+                             (options && i < orig_nb_streams) ? &options[i] : NULL);
+            st->codec_info_nb_frames++;
+        }
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt);
 
-        st->codec_info_nb_frames++;
         count++;
     }
 
+    stream_info_threads_wait(ic, -1);
+
     if (eof_reached) {
         int stream_index;
         for (stream_index = 0; stream_index < ic->nb_streams; stream_index++) {
@@ -3944,6 +4221,12 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
             /* flush the decoders */
             if (st->info->found_decoder == 1) {
+                err = stream_info_threads_submit(ic, st, NULL,
+                                                 (options && i < orig_nb_streams)
+                                                 ? &options[i] : NULL);
+                if (err)
+                    continue;
+
                 do {
                     err = try_decode_frame(ic, st, &empty_pkt,
                                             (options && i < orig_nb_streams)
@@ -3956,8 +4239,11 @@ FF_ENABLE_DEPRECATION_WARNINGS
                 }
             }
         }
+        stream_info_threads_wait(ic, -1);
     }
 
+    stream_info_threads_free(ic);
+
     ff_rfps_calculate(ic);
 
     for (i = 0; i < ic->nb_streams; i++) {
@@ -4148,6 +4434,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     }
 
 find_stream_info_err:
+    stream_info_threads_free(ic);
     for (i = 0; i < ic->nb_streams; i++) {
         st = ic->streams[i];
         if (st->info)
@@ -5005,6 +5292,9 @@ int avformat_network_init(void)
 int avformat_network_deinit(void)
 {
 #if CONFIG_NETWORK
+#if CONFIG_HTTP_PROTOCOL || CONFIG_HTTPS_PROTOCOL || CONFIG_HTTPPROXY_PROTOCOL
+    ff_http_pool_close();
+#endif
     ff_network_close();
     ff_tls_deinit();
 #endif
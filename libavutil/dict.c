@@ -20,6 +20,7 @@
 
 #include <string.h>
 
+#include "avassert.h"
 #include "avstring.h"
 #include "dict.h"
 #include "internal.h"
@@ -30,13 +31,117 @@
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+
+    /**
+     * Optional hash index over elems, built once the dictionary grows past
+     * DICT_INDEX_THRESHOLD entries. buckets holds the first element of each
+     * chain, next links elements with the same bucket, -1 ends a chain.
+     * Both arrays have index_size entries; index_size is 0 without index.
+     */
+    int *buckets;
+    int *next;
+    unsigned index_size;
 };
 
+#define DICT_INDEX_THRESHOLD 16
+
 int av_dict_count(const AVDictionary *m)
 {
     return m ? m->count : 0;
 }
 
+/* case insensitive FNV-1a, so that equal keys hash equally for any flags */
+static unsigned dict_hash(const char *key)
+{
+    unsigned h = 2166136261U;
+
+    while (*key)
+        h = (h ^ av_toupper(*key++)) * 16777619U;
+    return h;
+}
+
+static void dict_index_free(AVDictionary *m)
+{
+    av_freep(&m->buckets);
+    av_freep(&m->next);
+    m->index_size = 0;
+}
+
+static void dict_index_link(AVDictionary *m, int i)
+{
+    unsigned b = dict_hash(m->elems[i].key) & (m->index_size - 1);
+
+    m->next[i]    = m->buckets[b];
+    m->buckets[b] = i;
+}
+
+static void dict_index_build(AVDictionary *m, unsigned size)
+{
+    int i;
+
+    dict_index_free(m);
+    m->buckets = av_malloc_array(size, sizeof(*m->buckets));
+    m->next    = av_malloc_array(size, sizeof(*m->next));
+    if (!m->buckets || !m->next) {
+        /* not fatal, lookups fall back to the linear scan */
+        dict_index_free(m);
+        return;
+    }
+    m->index_size = size;
+    memset(m->buckets, -1, size * sizeof(*m->buckets));
+    for (i = 0; i < m->count; i++)
+        dict_index_link(m, i);
+}
+
+/* element i was appended at the end of elems */
+static void dict_index_add(AVDictionary *m, int i)
+{
+    if (i >= m->index_size) {
+        if (m->count >= DICT_INDEX_THRESHOLD)
+            dict_index_build(m, FFMAX(2 * m->index_size, 2 * DICT_INDEX_THRESHOLD));
+    } else if (m->index_size) {
+        dict_index_link(m, i);
+    }
+}
+
+/* element from is about to be removed (to < 0) or moved to slot to */
+static void dict_index_replace(AVDictionary *m, int from, int to)
+{
+    unsigned b;
+    int *p;
+
+    if (!m->index_size)
+        return;
+
+    b = dict_hash(m->elems[from].key) & (m->index_size - 1);
+    for (p = &m->buckets[b]; *p != from; p = &m->next[*p])
+        av_assert2(*p >= 0);
+    if (to < 0) {
+        *p = m->next[from];
+    } else {
+        *p = to;
+        m->next[to] = m->next[from];
+    }
+}
+
+static AVDictionaryEntry *dict_index_get(const AVDictionary *m, const char *key,
+                                         int start, int flags)
+{
+    unsigned b = dict_hash(key) & (m->index_size - 1);
+    int i, best = -1;
+
+    /* chains are not sorted, keep the first match in insertion order */
+    for (i = m->buckets[b]; i >= 0; i = m->next[i]) {
+        if (i < start || (best >= 0 && i > best))
+            continue;
+        if (flags & AV_DICT_MATCH_CASE ? strcmp(m->elems[i].key, key)
+                                       : av_strcasecmp(m->elems[i].key, key))
+            continue;
+        best = i;
+    }
+    return best >= 0 ? &m->elems[best] : NULL;
+}
+
 AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
                                const AVDictionaryEntry *prev, int flags)
 {
@@ -50,6 +155,9 @@ AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
     else
         i = 0;
 
+    if (m->index_size && !(flags & AV_DICT_IGNORE_SUFFIX))
+        return dict_index_get(m, key, i, flags);
+
     for (; i < m->count; i++) {
         const char *s = m->elems[i].key;
         if (flags & AV_DICT_MATCH_CASE)
@@ -100,6 +208,9 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             oldval = tag->value;
         else
             av_free(tag->value);
+        dict_index_replace(m, tag - m->elems, -1);
+        if (tag != &m->elems[m->count - 1])
+            dict_index_replace(m, m->count - 1, tag - m->elems);
         av_free(tag->key);
         *tag = m->elems[--m->count];
     } else if (copy_value) {
@@ -124,10 +235,12 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_freep(&copy_value);
         }
         m->count++;
+        dict_index_add(m, m->count - 1);
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
+        dict_index_free(m);
         av_freep(&m->elems);
         av_freep(pm);
     }
@@ -136,6 +249,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 
 err_out:
     if (m && !m->count) {
+        dict_index_free(m);
         av_freep(&m->elems);
         av_freep(pm);
     }
@@ -209,6 +323,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].key);
             av_freep(&m->elems[m->count].value);
         }
+        dict_index_free(m);
         av_freep(&m->elems);
     }
     av_freep(pm);
@@ -297,60 +297,306 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
     return ret;
 }
 
-void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+static void log_print(int level, unsigned tint, const int type[2],
+                      char *part[4])
 {
-    static int print_prefix = 1;
     static int count;
     static char prev[LINE_SZ];
-    AVBPrint part[4];
-    char line[LINE_SZ];
     static int is_atty;
-    int type[2];
-    unsigned tint = 0;
-
-    if (level >= 0) {
-        tint = level & 0xff00;
-        level &= 0xff;
-    }
-
-    if (level > av_log_level)
-        return;
-    ff_mutex_lock(&mutex);
+    char line[LINE_SZ];
 
-    format_line(ptr, level, fmt, vl, part, &print_prefix, type);
-    snprintf(line, sizeof(line), "%s%s%s%s", part[0].str, part[1].str, part[2].str, part[3].str);
+    snprintf(line, sizeof(line), "%s%s%s%s", part[0], part[1], part[2], part[3]);
 
 #if HAVE_ISATTY
     if (!is_atty)
         is_atty = isatty(2) ? 1 : -1;
 #endif
 
-    if (print_prefix && (flags & AV_LOG_SKIP_REPEATED) && !strcmp(line, prev) &&
-        *line && line[strlen(line) - 1] != '\r'){
+    /* only fold complete lines */
+    if ((flags & AV_LOG_SKIP_REPEATED) && !strcmp(line, prev) &&
+        *line && line[strlen(line) - 1] == '\n'){
         count++;
         if (is_atty == 1)
             fprintf(stderr, "    Last message repeated %d times\r", count);
-        goto end;
+        return;
     }
     if (count > 0) {
         fprintf(stderr, "    Last message repeated %d times\n", count);
         count = 0;
     }
     strcpy(prev, line);
-    sanitize(part[0].str);
-    colored_fputs(type[0], 0, part[0].str);
-    sanitize(part[1].str);
-    colored_fputs(type[1], 0, part[1].str);
-    sanitize(part[2].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2].str);
-    sanitize(part[3].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3].str);
+    sanitize(part[0]);
+    colored_fputs(type[0], 0, part[0]);
+    sanitize(part[1]);
+    colored_fputs(type[1], 0, part[1]);
+    sanitize(part[2]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2]);
+    sanitize(part[3]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3]);
 
 #if CONFIG_VALGRIND_BACKTRACE
     if (level <= BACKTRACE_LOGLEVEL)
         VALGRIND_PRINTF_BACKTRACE("%s", "");
 #endif
-end:
+}
+
+#if HAVE_THREADS
+#define ASYNC_QUEUE_SIZE 256
+
+typedef struct LogEntry {
+    int level;
+    unsigned tint;
+    int type[2];
+    int offset[4];              ///< start of each part in str
+    char str[LINE_SZ];
+} LogEntry;
+
+/* Lines queued by av_log_default_callback() in AV_LOG_ASYNC mode, written
+ * to stderr by a background thread. Protected by async_lock, writers of
+ * the queue additionally hold the global log mutex. */
+static pthread_mutex_t async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_cond;
+static pthread_t async_thread;
+static LogEntry *async_queue;
+static int async_head, async_count;
+static int async_dropped;
+static int async_running, async_exit;
+static int async_failed;
+
+static void *async_log_thread(void *arg)
+{
+    pthread_mutex_lock(&async_lock);
+    for (;;) {
+        LogEntry *e;
+        char *part[4];
+        int i, dropped;
+
+        while (!async_count && !async_dropped && !async_exit)
+            pthread_cond_wait(&async_cond, &async_lock);
+        if (!async_count && !async_dropped)
+            break;
+
+        /* the count and the entry are only cleared once they have been
+         * written, so that async_log_flush() waits for them */
+        dropped = async_dropped;
+        e = async_count ? &async_queue[async_head] : NULL;
+        pthread_mutex_unlock(&async_lock);
+
+        if (dropped)
+            fprintf(stderr, "    %d log messages dropped\n", dropped);
+        if (e) {
+            for (i = 0; i < 4; i++)
+                part[i] = e->str + e->offset[i];
+            log_print(e->level, e->tint, e->type, part);
+        }
+
+        pthread_mutex_lock(&async_lock);
+        async_dropped -= dropped;
+        if (e) {
+            async_head = (async_head + 1) % ASYNC_QUEUE_SIZE;
+            async_count--;
+        }
+        pthread_cond_broadcast(&async_cond);
+    }
+    pthread_mutex_unlock(&async_lock);
+
+    return NULL;
+}
+
+/* must be called with the global log mutex held */
+static int async_log_start(void)
+{
+    if (async_running)
+        return 0;
+    /* do not retry on every message, log synchronously from now on */
+    if (async_failed)
+        return AVERROR(EAGAIN);
+
+    async_queue = av_malloc_array(ASYNC_QUEUE_SIZE, sizeof(*async_queue));
+    if (!async_queue) {
+        async_failed = 1;
+        return AVERROR(ENOMEM);
+    }
+    async_head = async_count = async_dropped = async_exit = 0;
+    pthread_cond_init(&async_cond, NULL);
+    if (pthread_create(&async_thread, NULL, async_log_thread, NULL)) {
+        pthread_cond_destroy(&async_cond);
+        av_freep(&async_queue);
+        async_failed = 1;
+        return AVERROR(EAGAIN);
+    }
+    async_running = 1;
+    return 0;
+}
+
+/* must be called with the global log mutex held */
+static void async_log_flush(void)
+{
+    pthread_mutex_lock(&async_lock);
+    while (async_count || async_dropped)
+        pthread_cond_wait(&async_cond, &async_lock);
+    pthread_mutex_unlock(&async_lock);
+}
+
+/* must be called with the global log mutex held */
+static void async_log_stop(void)
+{
+    if (!async_running)
+        return;
+
+    pthread_mutex_lock(&async_lock);
+    async_exit = 1;
+    pthread_cond_broadcast(&async_cond);
+    pthread_mutex_unlock(&async_lock);
+
+    pthread_join(async_thread, NULL);
+    pthread_cond_destroy(&async_cond);
+    av_freep(&async_queue);
+    async_running = 0;
+}
+
+/**
+ * Queue a formatted line for the background writer.
+ * Returns 0 if the line has been queued or dropped, a negative value if
+ * the caller has to print it by itself.
+ */
+static int async_log_queue(int level, unsigned tint, const int type[2],
+                           AVBPrint part[4])
+{
+    LogEntry *e;
+    int i, pos = 0;
+
+    if (async_log_start() < 0)
+        return -1;
+
+    for (i = 0; i < 4; i++)
+        pos += part[i].len + 1;
+    if (pos > LINE_SZ || !av_bprint_is_complete(part + 3)) {
+        /* too long for a queue entry, keep the order of the output */
+        async_log_flush();
+        return -1;
+    }
+
+    pthread_mutex_lock(&async_lock);
+    /* Verbose and debug output is dropped when the writer cannot keep up,
+     * more important messages wait for room in the queue. */
+    if (async_count == ASYNC_QUEUE_SIZE && level > AV_LOG_INFO) {
+        async_dropped++;
+        pthread_mutex_unlock(&async_lock);
+        return 0;
+    }
+    while (async_count == ASYNC_QUEUE_SIZE)
+        pthread_cond_wait(&async_cond, &async_lock);
+    e = &async_queue[(async_head + async_count) % ASYNC_QUEUE_SIZE];
+    pthread_mutex_unlock(&async_lock);
+
+    /* only this thread writes to the free slot, under the global mutex */
+    e->level        = level;
+    e->tint         = tint;
+    e->type[0]      = type[0];
+    e->type[1]      = type[1];
+    for (i = pos = 0; i < 4; i++) {
+        e->offset[i] = pos;
+        memcpy(e->str + pos, part[i].str, part[i].len + 1);
+        pos += part[i].len + 1;
+    }
+
+    pthread_mutex_lock(&async_lock);
+    async_count++;
+    pthread_cond_broadcast(&async_cond);
+    pthread_mutex_unlock(&async_lock);
+
+    /* make sure fatal errors are on the terminal before the caller exits */
+    if (level <= AV_LOG_FATAL)
+        async_log_flush();
+
+    return 0;
+}
+
+/**
+ * Format a line and queue it for the background writer. The line is
+ * formatted without holding the global log mutex, unless another thread
+ * started or ended a line in the meantime.
+ * Returns a negative value if the caller has to log the line by itself.
+ */
+static int async_log(void *avcl, int level, unsigned tint, const char *fmt,
+                     va_list vl, int *print_prefix)
+{
+    AVBPrint part[4];
+    char *str[4];
+    int type[2];
+    int prefix, next;
+    va_list vl2;
+
+    ff_mutex_lock(&mutex);
+    if (async_log_start() < 0) {
+        ff_mutex_unlock(&mutex);
+        return -1;
+    }
+    prefix = *print_prefix;
+    ff_mutex_unlock(&mutex);
+
+    next = prefix;
+    va_copy(vl2, vl);
+    format_line(avcl, level, fmt, vl2, part, &next, type);
+    va_end(vl2);
+
+    ff_mutex_lock(&mutex);
+    if (*print_prefix != prefix) {
+        av_bprint_finalize(part+3, NULL);
+        format_line(avcl, level, fmt, vl, part, print_prefix, type);
+    } else {
+        *print_prefix = next;
+    }
+
+    /* the async mode may have been switched off in the meantime */
+    if (!(flags & AV_LOG_ASYNC) ||
+        async_log_queue(level, tint, type, part) < 0) {
+        str[0] = part[0].str;
+        str[1] = part[1].str;
+        str[2] = part[2].str;
+        str[3] = part[3].str;
+        log_print(level, tint, type, str);
+    }
+
+    av_bprint_finalize(part+3, NULL);
+    ff_mutex_unlock(&mutex);
+    return 0;
+}
+#endif
+
+void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+{
+    static int print_prefix = 1;
+    AVBPrint part[4];
+    char *str[4];
+    int type[2];
+    unsigned tint = 0;
+
+    if (level >= 0) {
+        tint = level & 0xff00;
+        level &= 0xff;
+    }
+
+    if (level > av_log_level)
+        return;
+
+#if HAVE_THREADS
+    if ((flags & AV_LOG_ASYNC) &&
+        async_log(ptr, level, tint, fmt, vl, &print_prefix) >= 0)
+        return;
+#endif
+
+    ff_mutex_lock(&mutex);
+
+    format_line(ptr, level, fmt, vl, part, &print_prefix, type);
+
+    str[0] = part[0].str;
+    str[1] = part[1].str;
+    str[2] = part[2].str;
+    str[3] = part[3].str;
+    log_print(level, tint, type, str);
+
     av_bprint_finalize(part+3, NULL);
     ff_mutex_unlock(&mutex);
 }
@@ -389,6 +635,16 @@ void av_log_set_level(int level)
 
 void av_log_set_flags(int arg)
 {
+#if HAVE_THREADS
+    if (!(arg & AV_LOG_ASYNC)) {
+        /* write out and stop the background writer, if any */
+        ff_mutex_lock(&mutex);
+        async_log_stop();
+        flags = arg;
+        ff_mutex_unlock(&mutex);
+        return;
+    }
+#endif
     flags = arg;
 }
 
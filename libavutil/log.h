@@ -352,6 +352,19 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
  */
 #define AV_LOG_PRINT_LEVEL 2
 
+/**
+ * Write the output of the default log callback from a background thread.
+ * Messages are formatted by the calling thread and queued; terminal output
+ * no longer blocks it. If the writer cannot keep up, verbose and debug
+ * messages are dropped and the number of dropped messages is printed,
+ * more important messages wait for room in the queue. Fatal messages are
+ * written out before av_log() returns.
+ * Clearing the flag with av_log_set_flags() writes out all queued messages
+ * and stops the thread; applications should do so before exiting.
+ * Ignored if FFmpeg was built without threading support.
+ */
+#define AV_LOG_ASYNC 4
+
 void av_log_set_flags(int arg);
 int av_log_get_flags(void);
 
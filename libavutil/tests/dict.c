@@ -54,6 +54,8 @@ int main(void)
     AVDictionary *dict = NULL;
     AVDictionaryEntry *e;
     char *buffer = NULL;
+    char key[16];
+    int i;
 
     printf("Testing av_dict_get_string() and av_dict_parse_string()\n");
     av_dict_get_string(dict, &buffer, '=', ',');
@@ -132,5 +134,38 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting av_dict_get() on a hash indexed dictionary\n");
+    for (i = 0; i < 40; i++) {
+        snprintf(key, sizeof(key), "Key%d", i);
+        av_dict_set_int(&dict, key, i, 0);
+    }
+    av_dict_set(&dict, "key7", "overwritten", 0);
+    av_dict_set(&dict, "KEY13", NULL, 0);
+    av_dict_set(&dict, "key21", "dont overwrite", AV_DICT_DONT_OVERWRITE);
+    av_dict_set(&dict, "key22", "append", AV_DICT_APPEND);
+    av_dict_set(&dict, "multi", "1", AV_DICT_MULTIKEY);
+    av_dict_set(&dict, "multi", "2", AV_DICT_MULTIKEY);
+    av_dict_set(&dict, "MULTI", "3", AV_DICT_MULTIKEY);
+    print_dict(dict);
+    for (i = 0; i < 42; i += 7) {
+        snprintf(key, sizeof(key), "kEy%d", i);
+        e = av_dict_get(dict, key, NULL, 0);
+        printf("%s: %s\n", key, e ? e->value : "(null)");
+    }
+    e = av_dict_get(dict, "key13", NULL, 0);
+    printf("key13: %s\n", e ? e->value : "(null)");
+    e = av_dict_get(dict, "key3", NULL, AV_DICT_MATCH_CASE);
+    printf("key3 match case: %s\n", e ? e->value : "(null)");
+    e = NULL;
+    while ((e = av_dict_get(dict, "multi", e, 0)))
+        printf("%s %s\n", e->key, e->value);
+    e = NULL;
+    while ((e = av_dict_get(dict, "multi", e, AV_DICT_MATCH_CASE)))
+        printf("%s %s match case\n", e->key, e->value);
+    e = NULL;
+    while ((e = av_dict_get(dict, "Key3", e, AV_DICT_IGNORE_SUFFIX)))
+        printf("%s %s suffix\n", e->key, e->value);
+    av_dict_free(&dict);
+
     return 0;
 }
@@ -273,6 +273,97 @@ static void yuv2yuvX_sse3(const int16_t *filter, int filterSize,
               );
     }
 }
+
+#if HAVE_AVX2_INLINE
+/* Same arithmetic as yuv2yuvX_sse3(), but 32 pixels per iteration; the
+ * remaining pixels are done 16 at a time, so it writes no further past
+ * dstW than the SSE3 version does. */
+static void yuv2yuvX_avx2(const int16_t *filter, int filterSize,
+                          const int16_t **src, uint8_t *dest, int dstW,
+                          const uint8_t *dither, int offset)
+{
+    uint64_t dither8 = AV_RN64(dither);
+
+    if(((uintptr_t)dest) & 15){
+        yuv2yuvX_mmxext(filter, filterSize, src, dest, dstW, dither, offset);
+        return;
+    }
+    if (offset)
+        dither8 = dither8 >> 24 | dither8 << 40;
+    filterSize--;
+    __asm__ volatile(
+        "vmovq              %5, %%xmm3              \n\t"
+        "vpmovzxbw      %%xmm3, %%xmm3              \n\t"
+        "vinserti128        $1, %%xmm3, %%ymm3, %%ymm3 \n\t"
+        "vmovd              %4, %%xmm1              \n\t"
+        "vpbroadcastw   %%xmm1, %%ymm1              \n\t"
+        "vpsllw             $3, %%ymm1, %%ymm1      \n\t"
+        "vpaddw         %%ymm1, %%ymm3, %%ymm3      \n\t"
+        "vpsraw             $4, %%ymm3, %%ymm7      \n\t"
+        "movl               %3, %%ecx               \n\t"
+        "cmp                %6, %%"FF_REG_c"        \n\t"
+        "jae                                 3f     \n\t"
+        "1:                                         \n\t"
+        "vmovdqa        %%ymm7, %%ymm3              \n\t"
+        "vmovdqa        %%ymm7, %%ymm4              \n\t"
+        "mov                                 %0, %%"FF_REG_d"        \n\t"
+        "mov                        (%%"FF_REG_d"), %%"FF_REG_S"     \n\t"
+        ".p2align                             4             \n\t"
+        "2:                                                 \n\t"
+        "vpbroadcastq             8(%%"FF_REG_d"), %%ymm0   \n\t" /* filterCoeff */
+        "vpmulhw   (%%"FF_REG_S", %%"FF_REG_c", 2), %%ymm0, %%ymm2 \n\t" /* srcData */
+        "vpmulhw 32(%%"FF_REG_S", %%"FF_REG_c", 2), %%ymm0, %%ymm5 \n\t" /* srcData */
+        "add                                $16, %%"FF_REG_d"        \n\t"
+        "mov                        (%%"FF_REG_d"), %%"FF_REG_S"     \n\t"
+        "test                         %%"FF_REG_S", %%"FF_REG_S"     \n\t"
+        "vpaddw                   %%ymm2, %%ymm3, %%ymm3    \n\t"
+        "vpaddw                   %%ymm5, %%ymm4, %%ymm4    \n\t"
+        " jnz                                2b             \n\t"
+        "vpsraw                       $3, %%ymm3, %%ymm3    \n\t"
+        "vpsraw                       $3, %%ymm4, %%ymm4    \n\t"
+        "vpackuswb                %%ymm4, %%ymm3, %%ymm3    \n\t"
+        "vpermq                    $0xd8, %%ymm3, %%ymm3    \n\t"
+        "vextracti128                 $1, %%ymm3, %%xmm4    \n\t"
+        "vmovntdq                         %%xmm3,   (%1, %%"FF_REG_c") \n\t"
+        "vmovntdq                         %%xmm4, 16(%1, %%"FF_REG_c") \n\t"
+        "add                         $32, %%"FF_REG_c"      \n\t"
+        "cmp                          %6, %%"FF_REG_c"      \n\t"
+        "jb                                  1b             \n\t"
+        "3:                                                 \n\t"
+        "cmp                          %2, %%"FF_REG_c"      \n\t"
+        "jae                                 5f             \n\t"
+        "4:                                                 \n\t"
+        "vmovdqa        %%xmm7, %%xmm3              \n\t"
+        "vmovdqa        %%xmm7, %%xmm4              \n\t"
+        "mov                                 %0, %%"FF_REG_d"        \n\t"
+        "mov                        (%%"FF_REG_d"), %%"FF_REG_S"     \n\t"
+        "6:                                                 \n\t"
+        "vmovddup                 8(%%"FF_REG_d"), %%xmm0   \n\t" /* filterCoeff */
+        "vpmulhw   (%%"FF_REG_S", %%"FF_REG_c", 2), %%xmm0, %%xmm2 \n\t" /* srcData */
+        "vpmulhw 16(%%"FF_REG_S", %%"FF_REG_c", 2), %%xmm0, %%xmm5 \n\t" /* srcData */
+        "add                                $16, %%"FF_REG_d"        \n\t"
+        "mov                        (%%"FF_REG_d"), %%"FF_REG_S"     \n\t"
+        "test                         %%"FF_REG_S", %%"FF_REG_S"     \n\t"
+        "vpaddw                   %%xmm2, %%xmm3, %%xmm3    \n\t"
+        "vpaddw                   %%xmm5, %%xmm4, %%xmm4    \n\t"
+        " jnz                                6b             \n\t"
+        "vpsraw                       $3, %%xmm3, %%xmm3    \n\t"
+        "vpsraw                       $3, %%xmm4, %%xmm4    \n\t"
+        "vpackuswb                %%xmm4, %%xmm3, %%xmm3    \n\t"
+        "vmovntdq                         %%xmm3, (%1, %%"FF_REG_c") \n\t"
+        "add                         $16, %%"FF_REG_c"      \n\t"
+        "cmp                          %2, %%"FF_REG_c"      \n\t"
+        "jb                                  4b             \n\t"
+        "5:                                                 \n\t"
+        "vzeroupper                                         \n\t"
+          :: "g" (filter),
+          "r" (dest-offset), "g" ((x86_reg)(dstW+offset)), "m" (offset),
+          "m"(filterSize), "m"(dither8), "g" ((x86_reg)((dstW & ~31)+offset))
+          : XMM_CLOBBERS("%xmm0" , "%xmm1" , "%xmm2" , "%xmm3" , "%xmm4" , "%xmm5" , "%xmm7" ,)
+            "%"FF_REG_d, "%"FF_REG_S, "%"FF_REG_c, "memory"
+          );
+}
+#endif /* HAVE_AVX2_INLINE */
 #endif
 
 #endif /* HAVE_INLINE_ASM */
@@ -397,6 +488,12 @@ av_cold void ff_sws_init_swscale_x86(SwsContext *c)
             c->yuv2planeX = yuv2yuvX_sse3;
     }
 #endif
+#if HAVE_AVX2_INLINE
+    if (INLINE_AVX2(cpu_flags)) {
+        if (c->use_mmx_vfilter && !(c->flags & SWS_ACCURATE_RND))
+            c->yuv2planeX = yuv2yuvX_avx2;
+    }
+#endif
 
 #define ASSIGN_SCALE_FUNC2(hscalefn, filtersize, opt1, opt2) do { \
     if (c->srcBpc == 8) { \
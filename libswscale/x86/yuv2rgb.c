@@ -67,6 +67,81 @@ DECLARE_ASM_CONST(8, uint64_t, pb_07) = 0x0707070707070707ULL;
 #include "yuv2rgb_template.c"
 #endif /* HAVE_MMXEXT_INLINE && HAVE_6REGS */
 
+#if HAVE_SSSE3_INLINE && HAVE_6REGS
+/* pshufb masks building the three 16-byte blocks of 16 packed 24-bit
+ * pixels from the interleaved first/second components of pixels 0-7 (lo)
+ * and 8-15 (hi) and from the third components (c2). Both 128-bit lanes
+ * are identical for the AVX2 version. */
+#define SHUF24(...) { __VA_ARGS__, __VA_ARGS__ }
+DECLARE_ASM_CONST(32, uint8_t, rgb24_shuf0_lo)[32] =
+    SHUF24(   0,    1, 0x80,    2,    3, 0x80,    4,    5,
+           0x80,    6,    7, 0x80,    8,    9, 0x80,   10);
+DECLARE_ASM_CONST(32, uint8_t, rgb24_shuf0_c2)[32] =
+    SHUF24(0x80, 0x80,    0, 0x80, 0x80,    1, 0x80, 0x80,
+              2, 0x80, 0x80,    3, 0x80, 0x80,    4, 0x80);
+DECLARE_ASM_CONST(32, uint8_t, rgb24_shuf1_lo)[32] =
+    SHUF24(  11, 0x80,   12,   13, 0x80,   14,   15, 0x80,
+           0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80);
+DECLARE_ASM_CONST(32, uint8_t, rgb24_shuf1_hi)[32] =
+    SHUF24(0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+              0,    1, 0x80,    2,    3, 0x80,    4,    5);
+DECLARE_ASM_CONST(32, uint8_t, rgb24_shuf1_c2)[32] =
+    SHUF24(0x80,    5, 0x80, 0x80,    6, 0x80, 0x80,    7,
+           0x80, 0x80,    8, 0x80, 0x80,    9, 0x80, 0x80);
+DECLARE_ASM_CONST(32, uint8_t, rgb24_shuf2_hi)[32] =
+    SHUF24(0x80,    6,    7, 0x80,    8,    9, 0x80,   10,
+             11, 0x80,   12,   13, 0x80,   14,   15, 0x80);
+DECLARE_ASM_CONST(32, uint8_t, rgb24_shuf2_c2)[32] =
+    SHUF24(  10, 0x80, 0x80,   11, 0x80, 0x80,   12, 0x80,
+           0x80,   13, 0x80, 0x80,   14, 0x80, 0x80,   15);
+
+/* The MMX coefficients in SwsContext hold 4 words each; the SSSE3/AVX2
+ * versions read them from a table with one 32-byte row per constant. */
+#define SIMD_Y_COEFF  "0*32"
+#define SIMD_VR_COEFF "1*32"
+#define SIMD_UB_COEFF "2*32"
+#define SIMD_VG_COEFF "3*32"
+#define SIMD_UG_COEFF "4*32"
+#define SIMD_Y_OFFSET "5*32"
+#define SIMD_U_OFFSET "6*32"
+#define SIMD_V_OFFSET "7*32"
+#define SIMD_00FFW    "8*32"
+#define SIMD_COEFFS_SIZE (9 * 4)
+
+static void yuv2rgb_simd_coeffs(SwsContext *c, uint64_t *coeffs)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        coeffs[0 * 4 + i] = c->yCoeff;
+        coeffs[1 * 4 + i] = c->vrCoeff;
+        coeffs[2 * 4 + i] = c->ubCoeff;
+        coeffs[3 * 4 + i] = c->vgCoeff;
+        coeffs[4 * 4 + i] = c->ugCoeff;
+        coeffs[5 * 4 + i] = c->yOffset;
+        coeffs[6 * 4 + i] = c->uOffset;
+        coeffs[7 * 4 + i] = c->vOffset;
+        coeffs[8 * 4 + i] = mmx_00ffw;
+    }
+}
+
+// SSSE3 versions
+#undef RENAME
+#undef COMPILE_TEMPLATE_AVX2
+#define COMPILE_TEMPLATE_AVX2 0
+#define RENAME(a) a ## _ssse3
+#include "yuv2rgb_simd_template.c"
+
+// AVX2 versions
+#if HAVE_AVX2_INLINE
+#undef RENAME
+#undef COMPILE_TEMPLATE_AVX2
+#define COMPILE_TEMPLATE_AVX2 1
+#define RENAME(a) a ## _avx2
+#include "yuv2rgb_simd_template.c"
+#endif /* HAVE_AVX2_INLINE */
+#endif /* HAVE_SSSE3_INLINE && HAVE_6REGS */
+
 #endif /* HAVE_INLINE_ASM */
 
 av_cold SwsFunc ff_yuv2rgb_init_x86(SwsContext *c)
@@ -74,6 +149,60 @@ av_cold SwsFunc ff_yuv2rgb_init_x86(SwsContext *c)
 #if HAVE_MMX_INLINE && HAVE_6REGS
     int cpu_flags = av_get_cpu_flags();
 
+#if HAVE_SSSE3_INLINE && HAVE_AVX2_INLINE
+    if (INLINE_AVX2(cpu_flags) && c->dstW >= 32) {
+        switch (c->dstFormat) {
+        case AV_PIX_FMT_RGB32:
+            if (c->srcFormat == AV_PIX_FMT_YUVA420P) {
+#if HAVE_7REGS && CONFIG_SWSCALE_ALPHA
+                return yuva420_rgb32_avx2;
+#endif
+                break;
+            } else
+                return yuv420_rgb32_avx2;
+        case AV_PIX_FMT_BGR32:
+            if (c->srcFormat == AV_PIX_FMT_YUVA420P) {
+#if HAVE_7REGS && CONFIG_SWSCALE_ALPHA
+                return yuva420_bgr32_avx2;
+#endif
+                break;
+            } else
+                return yuv420_bgr32_avx2;
+        case AV_PIX_FMT_RGB24:
+            return yuv420_rgb24_avx2;
+        case AV_PIX_FMT_BGR24:
+            return yuv420_bgr24_avx2;
+        }
+    }
+#endif
+
+#if HAVE_SSSE3_INLINE
+    if (INLINE_SSSE3(cpu_flags) && c->dstW >= 16) {
+        switch (c->dstFormat) {
+        case AV_PIX_FMT_RGB32:
+            if (c->srcFormat == AV_PIX_FMT_YUVA420P) {
+#if HAVE_7REGS && CONFIG_SWSCALE_ALPHA
+                return yuva420_rgb32_ssse3;
+#endif
+                break;
+            } else
+                return yuv420_rgb32_ssse3;
+        case AV_PIX_FMT_BGR32:
+            if (c->srcFormat == AV_PIX_FMT_YUVA420P) {
+#if HAVE_7REGS && CONFIG_SWSCALE_ALPHA
+                return yuva420_bgr32_ssse3;
+#endif
+                break;
+            } else
+                return yuv420_bgr32_ssse3;
+        case AV_PIX_FMT_RGB24:
+            return yuv420_rgb24_ssse3;
+        case AV_PIX_FMT_BGR24:
+            return yuv420_bgr24_ssse3;
+        }
+    }
+#endif
+
 #if HAVE_MMXEXT_INLINE
     if (INLINE_MMXEXT(cpu_flags)) {
         switch (c->dstFormat) {
@@ -0,0 +1,409 @@
+/*
+ * SSSE3/AVX2 YUV to RGB converter
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "libavutil/x86/asm.h"
+#include "libswscale/swscale_internal.h"
+
+#undef XMM
+#undef OP
+#undef MOV
+#undef STEP
+#undef SIMD_YUV2RGB_LOAD
+#undef SIMD_STORE32
+#undef SIMD_STORE24
+#undef SIMD_YUV2RGB_ENDFUNC
+
+/* OP() emits a two operand "op src, dst" for SSE and the equivalent
+ * three operand "vop src, dst, dst" for AVX2, so the arithmetic below is
+ * shared by both versions. */
+#if COMPILE_TEMPLATE_AVX2
+#define XMM(n) "%%ymm" n
+#define OP(op, src, dst) "v" op " " src ", " dst ", " dst "\n\t"
+#define MOV(op, src, dst) "v" op " " src ", " dst "\n\t"
+#define STEP 32
+#define SIMD_YUV2RGB_ENDFUNC __asm__ volatile ("vzeroupper\n\t");
+#else
+#define XMM(n) "%%xmm" n
+#define OP(op, src, dst) op " " src ", " dst "\n\t"
+#define MOV(op, src, dst) op " " src ", " dst "\n\t"
+#define STEP 16
+#define SIMD_YUV2RGB_ENDFUNC
+#endif
+
+/* Input: STEP Y and STEP / 2 U and V samples, with U and V zero-extended
+ * to words. Within a 128-bit lane the chroma words line up with the even
+ * and odd luma bytes of the same lane. */
+#if COMPILE_TEMPLATE_AVX2
+#define SIMD_YUV2RGB_LOAD                        \
+    "1:                                 \n\t"    \
+    "vmovdqu   (%5, %0, 2), %%ymm6      \n\t"    \
+    "vpmovzxbw (%2, %0),    %%ymm0      \n\t"    \
+    "vpmovzxbw (%3, %0),    %%ymm1      \n\t"
+#else
+#define SIMD_YUV2RGB_LOAD                        \
+    "1:                                 \n\t"    \
+    "movdqu    (%5, %0, 2), %%xmm6      \n\t"    \
+    "movq      (%2, %0),    %%xmm0      \n\t"    \
+    "movq      (%3, %0),    %%xmm1      \n\t"    \
+    "pxor      %%xmm4,      %%xmm4      \n\t"    \
+    "punpcklbw %%xmm4,      %%xmm0      \n\t"    \
+    "punpcklbw %%xmm4,      %%xmm1      \n\t"
+#endif
+
+/* Same arithmetic as YUV2RGB in yuv2rgb_template.c, so the output matches
+ * the MMX version bit for bit.
+ * Output:
+ * reg0 - B even, reg3 - B odd, reg1 - R even, reg5 - R odd,
+ * reg2 - G even, reg7 - G odd */
+#define SIMD_YUV2RGB                                         \
+    MOV("movdqa", XMM("6"), XMM("7"))                        \
+    OP("pand",   SIMD_00FFW"(%4)", XMM("6"))                 \
+    OP("psrlw",  "$8",             XMM("7"))                 \
+    OP("psllw",  "$3",             XMM("0"))                 \
+    OP("psllw",  "$3",             XMM("1"))                 \
+    OP("psllw",  "$3",             XMM("6"))                 \
+    OP("psllw",  "$3",             XMM("7"))                 \
+    OP("psubsw", SIMD_U_OFFSET"(%4)", XMM("0"))              \
+    OP("psubsw", SIMD_V_OFFSET"(%4)", XMM("1"))              \
+    OP("psubw",  SIMD_Y_OFFSET"(%4)", XMM("6"))              \
+    OP("psubw",  SIMD_Y_OFFSET"(%4)", XMM("7"))              \
+                                                             \
+    MOV("movdqa", XMM("0"), XMM("2"))                        \
+    MOV("movdqa", XMM("1"), XMM("3"))                        \
+    OP("pmulhw", SIMD_UG_COEFF"(%4)", XMM("2"))              \
+    OP("pmulhw", SIMD_VG_COEFF"(%4)", XMM("3"))              \
+    OP("pmulhw", SIMD_Y_COEFF"(%4)",  XMM("6"))              \
+    OP("pmulhw", SIMD_Y_COEFF"(%4)",  XMM("7"))              \
+    OP("pmulhw", SIMD_UB_COEFF"(%4)", XMM("0"))              \
+    OP("pmulhw", SIMD_VR_COEFF"(%4)", XMM("1"))              \
+    OP("paddsw", XMM("3"), XMM("2"))                         \
+                                                             \
+    MOV("movdqa", XMM("7"), XMM("3"))                        \
+    MOV("movdqa", XMM("7"), XMM("5"))                        \
+    OP("paddsw", XMM("0"), XMM("3"))                         \
+    OP("paddsw", XMM("1"), XMM("5"))                         \
+    OP("paddsw", XMM("2"), XMM("7"))                         \
+    OP("paddsw", XMM("6"), XMM("0"))                         \
+    OP("paddsw", XMM("6"), XMM("1"))                         \
+    OP("paddsw", XMM("6"), XMM("2"))
+
+/* Output: reg0 - B, reg1 - R, reg2 - G, in pixel order */
+#define SIMD_PACK_INTERLEAVE                                 \
+    OP("packuswb",  XMM("1"), XMM("0"))                      \
+    OP("packuswb",  XMM("5"), XMM("3"))                      \
+    OP("packuswb",  XMM("7"), XMM("2"))                      \
+    MOV("movdqa",   XMM("0"), XMM("1"))                      \
+    OP("punpcklbw", XMM("3"), XMM("0"))                      \
+    OP("punpckhbw", XMM("3"), XMM("1"))                      \
+    MOV("pshufd",   "$0xee, " XMM("2"), XMM("7"))            \
+    OP("punpcklbw", XMM("7"), XMM("2"))
+
+#define SET_EMPTY_ALPHA_SIMD                                 \
+    OP("pcmpeqd", XMM("3"), XMM("3"))
+
+#define LOAD_ALPHA_SIMD                                      \
+    MOV("movdqu", "(%6, %0, 2)", XMM("3"))
+
+/* Store c0 c1 c2 c3 bytes for each pixel.
+ * Pixels 0-3 end up in c0, 4-7 in reg7, 8-11 in reg5, 12-15 in c1. */
+#define SIMD_PACK32(c0, c1, c2, c3)                          \
+    MOV("movdqa",   XMM(c0), XMM("5"))                       \
+    OP("punpcklbw", XMM(c1), XMM(c0))                        \
+    OP("punpckhbw", XMM(c1), XMM("5"))                       \
+    MOV("movdqa",   XMM(c2), XMM("6"))                       \
+    OP("punpcklbw", XMM(c3), XMM(c2))                        \
+    OP("punpckhbw", XMM(c3), XMM("6"))                       \
+    MOV("movdqa",   XMM(c0), XMM("7"))                       \
+    OP("punpcklwd", XMM(c2), XMM(c0))                        \
+    OP("punpckhwd", XMM(c2), XMM("7"))                       \
+    MOV("movdqa",   XMM("5"), XMM(c1))                       \
+    OP("punpcklwd", XMM("6"), XMM("5"))                      \
+    OP("punpckhwd", XMM("6"), XMM(c1))                       \
+    SIMD_STORE32(c0, c1)
+
+#if COMPILE_TEMPLATE_AVX2
+#define SIMD_STORE32(c0, c1)                                              \
+    "vperm2i128 $0x20, %%ymm7, "XMM(c0)", %%ymm4     \n\t"                \
+    "vperm2i128 $0x20, "XMM(c1)", %%ymm5, %%ymm6     \n\t"                \
+    "vperm2i128 $0x31, %%ymm7, "XMM(c0)", "XMM(c0)"  \n\t"                \
+    "vperm2i128 $0x31, "XMM(c1)", %%ymm5, %%ymm5     \n\t"                \
+    "vmovdqu    %%ymm4,      (%1)                    \n\t"                \
+    "vmovdqu    %%ymm6,    32(%1)                    \n\t"                \
+    "vmovdqu    "XMM(c0)", 64(%1)                    \n\t"                \
+    "vmovdqu    %%ymm5,    96(%1)                    \n\t"
+#else
+#define SIMD_STORE32(c0, c1)                                              \
+    "movdqu     "XMM(c0)",   (%1)                    \n\t"                \
+    "movdqu     %%xmm7,    16(%1)                    \n\t"                \
+    "movdqu     %%xmm5,    32(%1)                    \n\t"                \
+    "movdqu     "XMM(c1)", 48(%1)                    \n\t"
+#endif
+
+/* Store c0 c1 c2 bytes for each pixel. c0 and c1 are interleaved first,
+ * then each 16-byte output block is gathered with pshufb from the c0/c1
+ * pairs and from c2, see the rgb24_shuf tables.
+ * Output bytes 0-15 end up in reg6, 16-31 in c0, 32-47 in reg5. */
+#define SIMD_PACK24(c0, c1, c2)                              \
+    MOV("movdqa",   XMM(c0), XMM("5"))                       \
+    OP("punpcklbw", XMM(c1), XMM(c0))                        \
+    OP("punpckhbw", XMM(c1), XMM("5"))                       \
+                                                             \
+    MOV("movdqa",   XMM(c0), XMM("6"))                       \
+    OP("pshufb",    MANGLE(rgb24_shuf0_lo), XMM("6"))        \
+    MOV("movdqa",   XMM(c2), XMM("7"))                       \
+    OP("pshufb",    MANGLE(rgb24_shuf0_c2), XMM("7"))        \
+    OP("por",       XMM("7"), XMM("6"))                      \
+                                                             \
+    OP("pshufb",    MANGLE(rgb24_shuf1_lo), XMM(c0))         \
+    MOV("movdqa",   XMM("5"), XMM("7"))                      \
+    OP("pshufb",    MANGLE(rgb24_shuf1_hi), XMM("7"))        \
+    OP("por",       XMM("7"), XMM(c0))                       \
+    MOV("movdqa",   XMM(c2), XMM("7"))                       \
+    OP("pshufb",    MANGLE(rgb24_shuf1_c2), XMM("7"))        \
+    OP("por",       XMM("7"), XMM(c0))                       \
+                                                             \
+    OP("pshufb",    MANGLE(rgb24_shuf2_hi), XMM("5"))        \
+    OP("pshufb",    MANGLE(rgb24_shuf2_c2), XMM(c2))         \
+    OP("por",       XMM(c2), XMM("5"))                       \
+    SIMD_STORE24(c0)
+
+#if COMPILE_TEMPLATE_AVX2
+#define SIMD_STORE24(c0)                                                  \
+    "vperm2i128 $0x20, "XMM(c0)", %%ymm6, %%ymm7     \n\t"                \
+    "vperm2i128 $0x30, %%ymm6, %%ymm5, %%ymm3        \n\t"                \
+    "vperm2i128 $0x31, %%ymm5, "XMM(c0)", %%ymm4     \n\t"                \
+    "vmovdqu    %%ymm7,      (%1)                    \n\t"                \
+    "vmovdqu    %%ymm3,    32(%1)                    \n\t"                \
+    "vmovdqu    %%ymm4,    64(%1)                    \n\t"
+#else
+#define SIMD_STORE24(c0)                                                  \
+    "movdqu     %%xmm6,      (%1)                    \n\t"                \
+    "movdqu     "XMM(c0)", 16(%1)                    \n\t"                \
+    "movdqu     %%xmm5,    32(%1)                    \n\t"
+#endif
+
+#define SIMD_YUV2RGB_ENDLOOP(depth)                          \
+    "add $"AV_STRINGIFY(STEP * depth)", %1\n\t"              \
+    "add $"AV_STRINGIFY(STEP / 2)",     %0\n\t"              \
+    "js   1b\n\t"
+
+#define SIMD_YUV2RGB_OPERANDS                                             \
+        : "+r" (index), "+r" (image)                                      \
+        : "r" (pu - index), "r" (pv - index), "r" (coeffs),               \
+          "r" (py - 2 * index)                                            \
+          NAMED_CONSTRAINTS_ARRAY_ADD(rgb24_shuf0_lo,rgb24_shuf0_c2,      \
+                                      rgb24_shuf1_lo,rgb24_shuf1_hi,      \
+                                      rgb24_shuf1_c2,rgb24_shuf2_hi,      \
+                                      rgb24_shuf2_c2)                     \
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",                \
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",)               \
+          "memory"                                                        \
+        );
+
+#define SIMD_YUV2RGB_OPERANDS_ALPHA                                       \
+        : "+r" (index), "+r" (image)                                      \
+        : "r" (pu - index), "r" (pv - index), "r" (coeffs),               \
+          "r" (py - 2 * index), "r" (pa - 2 * index)                      \
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",                \
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",)               \
+          "memory"                                                        \
+        );
+
+/**
+ * Convert width pixels of one line, width must be a multiple of STEP.
+ */
+static av_always_inline void RENAME(yuv2rgb_line)(const uint8_t *py,
+                                                  const uint8_t *pu,
+                                                  const uint8_t *pv,
+                                                  const uint8_t *pa,
+                                                  uint8_t *image, int width,
+                                                  const uint64_t *coeffs,
+                                                  enum AVPixelFormat dst_format,
+                                                  int alpha)
+{
+    x86_reg index = -width / 2;
+
+#if HAVE_7REGS && CONFIG_SWSCALE_ALPHA
+    if (alpha) {
+        if (dst_format == AV_PIX_FMT_RGB32) {
+            __asm__ volatile (
+                SIMD_YUV2RGB_LOAD
+                SIMD_YUV2RGB
+                SIMD_PACK_INTERLEAVE
+                LOAD_ALPHA_SIMD
+                SIMD_PACK32("0", "2", "1", "3")
+                SIMD_YUV2RGB_ENDLOOP(4)
+                SIMD_YUV2RGB_OPERANDS_ALPHA
+        } else {
+            __asm__ volatile (
+                SIMD_YUV2RGB_LOAD
+                SIMD_YUV2RGB
+                SIMD_PACK_INTERLEAVE
+                LOAD_ALPHA_SIMD
+                SIMD_PACK32("1", "2", "0", "3")
+                SIMD_YUV2RGB_ENDLOOP(4)
+                SIMD_YUV2RGB_OPERANDS_ALPHA
+        }
+        return;
+    }
+#endif
+
+    switch (dst_format) {
+    case AV_PIX_FMT_RGB32:
+        __asm__ volatile (
+            SIMD_YUV2RGB_LOAD
+            SIMD_YUV2RGB
+            SIMD_PACK_INTERLEAVE
+            SET_EMPTY_ALPHA_SIMD
+            SIMD_PACK32("0", "2", "1", "3")
+            SIMD_YUV2RGB_ENDLOOP(4)
+            SIMD_YUV2RGB_OPERANDS
+        break;
+    case AV_PIX_FMT_BGR32:
+        __asm__ volatile (
+            SIMD_YUV2RGB_LOAD
+            SIMD_YUV2RGB
+            SIMD_PACK_INTERLEAVE
+            SET_EMPTY_ALPHA_SIMD
+            SIMD_PACK32("1", "2", "0", "3")
+            SIMD_YUV2RGB_ENDLOOP(4)
+            SIMD_YUV2RGB_OPERANDS
+        break;
+    case AV_PIX_FMT_RGB24:
+        __asm__ volatile (
+            SIMD_YUV2RGB_LOAD
+            SIMD_YUV2RGB
+            SIMD_PACK_INTERLEAVE
+            SIMD_PACK24("1", "2", "0")
+            SIMD_YUV2RGB_ENDLOOP(3)
+            SIMD_YUV2RGB_OPERANDS
+        break;
+    case AV_PIX_FMT_BGR24:
+        __asm__ volatile (
+            SIMD_YUV2RGB_LOAD
+            SIMD_YUV2RGB
+            SIMD_PACK_INTERLEAVE
+            SIMD_PACK24("0", "2", "1")
+            SIMD_YUV2RGB_ENDLOOP(3)
+            SIMD_YUV2RGB_OPERANDS
+        break;
+    }
+}
+
+/* Lines are converted STEP pixels at a time; a width that is not a
+ * multiple of STEP is finished with one more STEP-wide block ending at
+ * h_size, which overlaps already written pixels with identical values.
+ * ff_yuv2rgb_init_x86() guarantees h_size >= STEP. */
+static av_always_inline int RENAME(yuv2rgb_simd)(SwsContext *c,
+                                                 const uint8_t *src[],
+                                                 int srcStride[],
+                                                 int srcSliceY, int srcSliceH,
+                                                 uint8_t *dst[], int dstStride[],
+                                                 enum AVPixelFormat dst_format,
+                                                 int depth, int alpha)
+{
+    LOCAL_ALIGNED_32(uint64_t, coeffs, [SIMD_COEFFS_SIZE]);
+    int y, h_size, tail, vshift;
+
+    h_size = (c->dstW + 7) & ~7;
+    if (h_size * depth > FFABS(dstStride[0]))
+        h_size -= 8;
+    tail = h_size - STEP;
+
+    vshift = c->srcFormat != AV_PIX_FMT_YUV422P;
+
+    yuv2rgb_simd_coeffs(c, coeffs);
+
+    for (y = 0; y < srcSliceH; y++) {
+        uint8_t *image    = dst[0] + (y + srcSliceY) * dstStride[0];
+        const uint8_t *py = src[0] +               y * srcStride[0];
+        const uint8_t *pu = src[1] +   (y >> vshift) * srcStride[1];
+        const uint8_t *pv = src[2] +   (y >> vshift) * srcStride[2];
+        const uint8_t *pa = alpha ? src[3] + y * srcStride[3] : NULL;
+
+        RENAME(yuv2rgb_line)(py, pu, pv, pa, image, h_size & ~(STEP - 1),
+                             coeffs, dst_format, alpha);
+        if (h_size & (STEP - 1))
+            RENAME(yuv2rgb_line)(py + tail, pu + tail / 2, pv + tail / 2,
+                                 alpha ? pa + tail : NULL, image + tail * depth,
+                                 STEP, coeffs, dst_format, alpha);
+    }
+
+    SIMD_YUV2RGB_ENDFUNC
+    return srcSliceH;
+}
+
+static int RENAME(yuv420_rgb24)(SwsContext *c, const uint8_t *src[],
+                                int srcStride[],
+                                int srcSliceY, int srcSliceH,
+                                uint8_t *dst[], int dstStride[])
+{
+    return RENAME(yuv2rgb_simd)(c, src, srcStride, srcSliceY, srcSliceH,
+                                dst, dstStride, AV_PIX_FMT_RGB24, 3, 0);
+}
+
+static int RENAME(yuv420_bgr24)(SwsContext *c, const uint8_t *src[],
+                                int srcStride[],
+                                int srcSliceY, int srcSliceH,
+                                uint8_t *dst[], int dstStride[])
+{
+    return RENAME(yuv2rgb_simd)(c, src, srcStride, srcSliceY, srcSliceH,
+                                dst, dstStride, AV_PIX_FMT_BGR24, 3, 0);
+}
+
+static int RENAME(yuv420_rgb32)(SwsContext *c, const uint8_t *src[],
+                                int srcStride[],
+                                int srcSliceY, int srcSliceH,
+                                uint8_t *dst[], int dstStride[])
+{
+    return RENAME(yuv2rgb_simd)(c, src, srcStride, srcSliceY, srcSliceH,
+                                dst, dstStride, AV_PIX_FMT_RGB32, 4, 0);
+}
+
+static int RENAME(yuv420_bgr32)(SwsContext *c, const uint8_t *src[],
+                                int srcStride[],
+                                int srcSliceY, int srcSliceH,
+                                uint8_t *dst[], int dstStride[])
+{
+    return RENAME(yuv2rgb_simd)(c, src, srcStride, srcSliceY, srcSliceH,
+                                dst, dstStride, AV_PIX_FMT_BGR32, 4, 0);
+}
+
+#if HAVE_7REGS && CONFIG_SWSCALE_ALPHA
+static int RENAME(yuva420_rgb32)(SwsContext *c, const uint8_t *src[],
+                                 int srcStride[],
+                                 int srcSliceY, int srcSliceH,
+                                 uint8_t *dst[], int dstStride[])
+{
+    return RENAME(yuv2rgb_simd)(c, src, srcStride, srcSliceY, srcSliceH,
+                                dst, dstStride, AV_PIX_FMT_RGB32, 4, 1);
+}
+
+static int RENAME(yuva420_bgr32)(SwsContext *c, const uint8_t *src[],
+                                 int srcStride[],
+                                 int srcSliceY, int srcSliceH,
+                                 uint8_t *dst[], int dstStride[])
+{
+    return RENAME(yuv2rgb_simd)(c, src, srcStride, srcSliceY, srcSliceH,
+                                dst, dstStride, AV_PIX_FMT_BGR32, 4, 1);
+}
+#endif
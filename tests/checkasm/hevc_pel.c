@@ -0,0 +1,195 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/hevcdsp.h"
+
+#include "checkasm.h"
+
+static const int widths[] = { 2, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+
+#define SRC_EXTRA   8
+#define SRC_STRIDE  ((MAX_PB_SIZE + 2 * SRC_EXTRA) * 2)
+#define SRC_SIZE    (SRC_STRIDE * (MAX_PB_SIZE + 2 * SRC_EXTRA))
+#define SRC_OFFSET  (SRC_EXTRA * SRC_STRIDE + SRC_EXTRA * 2)
+#define DST_STRIDE  (MAX_PB_SIZE * 2)
+#define DST_SIZE    (DST_STRIDE * MAX_PB_SIZE)
+
+#define randomize_pixels(buf, size, bit_depth)                      \
+    do {                                                            \
+        int j;                                                      \
+        if (bit_depth > 8) {                                        \
+            for (j = 0; j < size / 2; j++)                          \
+                AV_WN16A(buf + j * 2, rnd() & ((1 << bit_depth) - 1)); \
+        } else {                                                    \
+            for (j = 0; j < size; j++)                              \
+                buf[j] = rnd();                                     \
+        }                                                           \
+    } while (0)
+
+#define randomize_res(buf, size)                \
+    do {                                        \
+        int j;                                  \
+        for (j = 0; j < size; j++)              \
+            buf[j] = (int16_t)rnd() >> 3;       \
+    } while (0)
+
+static void check_pel(int bit_depth, int nb_frac,
+                      void (*fn[10][2][2])(int16_t *, uint8_t *, ptrdiff_t,
+                                           int, intptr_t, intptr_t, int),
+                      const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [SRC_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, dst0, [MAX_PB_SIZE * MAX_PB_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, dst1, [MAX_PB_SIZE * MAX_PB_SIZE]);
+    int i, mx, my;
+
+    declare_func(void, int16_t *dst, uint8_t *src, ptrdiff_t srcstride,
+                 int height, intptr_t mx, intptr_t my, int width);
+
+    randomize_pixels(src, SRC_SIZE, bit_depth);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        int w = widths[i];
+        for (my = 0; my < 2; my++) {
+            for (mx = 0; mx < 2; mx++) {
+                intptr_t fx = mx ? 1 + rnd() % (nb_frac - 1) : 0;
+                intptr_t fy = my ? 1 + rnd() % (nb_frac - 1) : 0;
+                if (check_func(fn[i][my][mx], "put_hevc_%s%s%s%d_%d", name,
+                               mx ? "_h" : "", my ? "_v" : "", w, bit_depth)) {
+                    memset(dst0, 0, sizeof(*dst0) * MAX_PB_SIZE * MAX_PB_SIZE);
+                    memset(dst1, 0, sizeof(*dst1) * MAX_PB_SIZE * MAX_PB_SIZE);
+                    call_ref(dst0, src + SRC_OFFSET, SRC_STRIDE, w, fx, fy, w);
+                    call_new(dst1, src + SRC_OFFSET, SRC_STRIDE, w, fx, fy, w);
+                    if (memcmp(dst0, dst1, sizeof(*dst0) * MAX_PB_SIZE * w))
+                        fail();
+                    bench_new(dst1, src + SRC_OFFSET, SRC_STRIDE, w, fx, fy, w);
+                }
+            }
+        }
+    }
+}
+
+static void check_pel_uni(int bit_depth, int nb_frac,
+                          void (*fn[10][2][2])(uint8_t *, ptrdiff_t, uint8_t *, ptrdiff_t,
+                                               int, intptr_t, intptr_t, int),
+                          const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [SRC_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_SIZE]);
+    int i, mx, my;
+
+    declare_func(void, uint8_t *dst, ptrdiff_t dststride, uint8_t *src, ptrdiff_t srcstride,
+                 int height, intptr_t mx, intptr_t my, int width);
+
+    randomize_pixels(src, SRC_SIZE, bit_depth);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        int w = widths[i];
+        for (my = 0; my < 2; my++) {
+            for (mx = 0; mx < 2; mx++) {
+                intptr_t fx = mx ? 1 + rnd() % (nb_frac - 1) : 0;
+                intptr_t fy = my ? 1 + rnd() % (nb_frac - 1) : 0;
+                if (check_func(fn[i][my][mx], "put_hevc_%s_uni%s%s%d_%d", name,
+                               mx ? "_h" : "", my ? "_v" : "", w, bit_depth)) {
+                    memset(dst0, 0, DST_SIZE);
+                    memset(dst1, 0, DST_SIZE);
+                    call_ref(dst0, DST_STRIDE, src + SRC_OFFSET, SRC_STRIDE, w, fx, fy, w);
+                    call_new(dst1, DST_STRIDE, src + SRC_OFFSET, SRC_STRIDE, w, fx, fy, w);
+                    if (memcmp(dst0, dst1, DST_STRIDE * w))
+                        fail();
+                    bench_new(dst1, DST_STRIDE, src + SRC_OFFSET, SRC_STRIDE, w, fx, fy, w);
+                }
+            }
+        }
+    }
+}
+
+static void check_pel_bi(int bit_depth, int nb_frac,
+                         void (*fn[10][2][2])(uint8_t *, ptrdiff_t, uint8_t *, ptrdiff_t,
+                                              int16_t *, int, intptr_t, intptr_t, int),
+                         const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [SRC_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, src2, [MAX_PB_SIZE * MAX_PB_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_SIZE]);
+    int i, mx, my;
+
+    declare_func(void, uint8_t *dst, ptrdiff_t dststride, uint8_t *src, ptrdiff_t srcstride,
+                 int16_t *src2, int height, intptr_t mx, intptr_t my, int width);
+
+    randomize_pixels(src, SRC_SIZE, bit_depth);
+    randomize_res(src2, MAX_PB_SIZE * MAX_PB_SIZE);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        int w = widths[i];
+        for (my = 0; my < 2; my++) {
+            for (mx = 0; mx < 2; mx++) {
+                intptr_t fx = mx ? 1 + rnd() % (nb_frac - 1) : 0;
+                intptr_t fy = my ? 1 + rnd() % (nb_frac - 1) : 0;
+                if (check_func(fn[i][my][mx], "put_hevc_%s_bi%s%s%d_%d", name,
+                               mx ? "_h" : "", my ? "_v" : "", w, bit_depth)) {
+                    memset(dst0, 0, DST_SIZE);
+                    memset(dst1, 0, DST_SIZE);
+                    call_ref(dst0, DST_STRIDE, src + SRC_OFFSET, SRC_STRIDE, src2, w, fx, fy, w);
+                    call_new(dst1, DST_STRIDE, src + SRC_OFFSET, SRC_STRIDE, src2, w, fx, fy, w);
+                    if (memcmp(dst0, dst1, DST_STRIDE * w))
+                        fail();
+                    bench_new(dst1, DST_STRIDE, src + SRC_OFFSET, SRC_STRIDE, src2, w, fx, fy, w);
+                }
+            }
+        }
+    }
+}
+
+void checkasm_check_hevc_pel(void)
+{
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth += 2) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_pel(bit_depth, 4, h.put_hevc_qpel, "qpel");
+        check_pel(bit_depth, 8, h.put_hevc_epel, "epel");
+    }
+    report("pel");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth += 2) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_pel_uni(bit_depth, 4, h.put_hevc_qpel_uni, "qpel");
+        check_pel_uni(bit_depth, 8, h.put_hevc_epel_uni, "epel");
+    }
+    report("pel_uni");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth += 2) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_pel_bi(bit_depth, 4, h.put_hevc_qpel_bi, "qpel");
+        check_pel_bi(bit_depth, 8, h.put_hevc_epel_bi, "epel");
+    }
+    report("pel_bi");
+}
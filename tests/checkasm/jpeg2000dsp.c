@@ -88,6 +88,27 @@ static void check_ict_float(void)
     bench_new(new0, new1, new2, BUF_SIZE);
 }
 
+static void check_dwt97_lift_float(void)
+{
+    LOCAL_ALIGNED_32(float, src, [BUF_SIZE*3]);
+    LOCAL_ALIGNED_32(float, ref, [BUF_SIZE*3]);
+    LOCAL_ALIGNED_32(float, new, [BUF_SIZE*3]);
+    /* rows of 8 columns, every odd one gets updated */
+    const int rows = (BUF_SIZE * 3 / 8 - 1) / 2;
+
+    declare_func_float(void, float *p, float coef, int n);
+
+    randomize_buffers_float();
+    memcpy(ref, src, BUF_SIZE * 3 * sizeof(*src));
+    memcpy(new, src, BUF_SIZE * 3 * sizeof(*src));
+    call_ref(ref + 8, -0.443506852043971f, rows);
+    call_new(new + 8, -0.443506852043971f, rows);
+    if (!float_near_abs_eps_array(ref, new, 1.0e-5, BUF_SIZE * 3))
+        fail();
+    memcpy(new, src, BUF_SIZE * 3 * sizeof(*src));
+    bench_new(new + 8, -0.443506852043971f, rows);
+}
+
 void checkasm_check_jpeg2000dsp(void)
 {
     Jpeg2000DSPContext h;
@@ -100,4 +121,9 @@ void checkasm_check_jpeg2000dsp(void)
         check_ict_float();
 
     report("mct_decode");
+
+    if (check_func(h.dwt97_lift_float, "jpeg2000_dwt97_lift_float"))
+        check_dwt97_lift_float();
+
+    report("dwt97_lift_float");
 }
@@ -0,0 +1,109 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/me_cmp.h"
+
+#include "checkasm.h"
+
+#define STRIDE   64
+#define BUF_SIZE (STRIDE * 40)
+
+#define randomize_buffer(buf, mask)             \
+    do {                                        \
+        int j;                                  \
+        for (j = 0; j < BUF_SIZE; j++)          \
+            buf[j] = rnd() & mask;              \
+    } while (0)
+
+static void check_cmp(me_cmp_func func, const char *name, int w, int h,
+                      uint8_t *pix1, uint8_t *pix2)
+{
+    declare_func_emms(AV_CPU_FLAG_MMX, int, struct MpegEncContext *c,
+                      uint8_t *blk1, uint8_t *blk2, ptrdiff_t stride, int h);
+
+    if (check_func(func, "%s_%dx%d", name, w, h)) {
+        int i;
+
+        for (i = 0; i < 4; i++) {
+            /* blk1 is aligned to the block width, blk2 is unaligned */
+            uint8_t *blk1 = pix1 + (rnd() % 8) * STRIDE + (rnd() % (STRIDE / w - 1)) * w;
+            uint8_t *blk2 = pix2 + (rnd() % 8) * STRIDE + rnd() % (STRIDE - w - 1);
+            int ref = call_ref(NULL, blk1, blk2, STRIDE, h);
+            int new = call_new(NULL, blk1, blk2, STRIDE, h);
+
+            if (ref != new) {
+                fprintf(stderr, "%s_%dx%d: %d != %d\n", name, w, h, ref, new);
+                fail();
+                break;
+            }
+        }
+        bench_new(NULL, pix1, pix2 + 1, STRIDE, h);
+    }
+}
+
+void checkasm_check_me_cmp(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, pix1, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, pix2, [BUF_SIZE]);
+    AVCodecContext avctx = {
+        .flags = AV_CODEC_FLAG_BITEXACT,
+    };
+    MECmpContext c;
+    static const char *const pix_abs_names[4] = {
+        "pix_abs", "pix_abs_x2", "pix_abs_y2", "pix_abs_xy2"
+    };
+    int i, j, h;
+
+    memset(&c, 0, sizeof(c));
+    ff_me_cmp_init(&c, &avctx);
+
+    randomize_buffer(pix1, 0xFF);
+    randomize_buffer(pix2, 0xFF);
+
+    /* the 8 pixel wide MMX functions only handle 8x8 blocks */
+    for (i = 0; i < 2; i++) {
+        int w = 16 >> i;
+
+        for (h = w; h >= 8; h >>= 1) {
+            for (j = 0; j < 4; j++)
+                check_cmp(c.pix_abs[i][j], pix_abs_names[j], w, h, pix1, pix2);
+            check_cmp(c.sad[i], "sad", w, h, pix1, pix2);
+            check_cmp(c.sse[i], "sse", w, h, pix1, pix2);
+        }
+        check_cmp(c.vsad[i + 4], "vsad_intra", w, w, pix1, pix2);
+    }
+    check_cmp(c.sse[2], "sse", 4, 4, pix1, pix2);
+    report("sad");
+
+    /* the SIMD Hadamard transforms use saturating 16-bit sums,
+     * so keep the differences small enough for them to be exact */
+    randomize_buffer(pix1, 0x0F);
+    randomize_buffer(pix2, 0x0F);
+
+    check_cmp(c.hadamard8_diff[0], "hadamard8_diff", 16, 16, pix1, pix2);
+    check_cmp(c.hadamard8_diff[0], "hadamard8_diff", 16, 8,  pix1, pix2);
+    check_cmp(c.hadamard8_diff[1], "hadamard8_diff", 8,  8,  pix1, pix2);
+    report("hadamard8_diff");
+}
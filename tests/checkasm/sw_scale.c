@@ -0,0 +1,286 @@
+/*
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#include "checkasm.h"
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        for (j = 0; j < size; j+=4)       \
+            AV_WN32(buf + j, rnd());      \
+    } while (0)
+
+#define MAX_WIDTH   512
+#define SRC_WIDTH   (2 * MAX_WIDTH + 64)
+/* initFilter() pads filterPos[] and filter[] by this many entries */
+#define FILTER_PAD  3
+
+static const int widths[] = { 8, 17, 24, 128, 144, 256, 511, 512 };
+
+static void check_hscale(void)
+{
+    static const int filter_sizes[] = { 4, 8, 12, 16, 40 };
+    static const int dst_bpcs[]     = { 8, 16 };
+    int fsi, bpci, wi, i, j;
+    struct SwsContext *ctx;
+
+    LOCAL_ALIGNED_32(uint8_t, src, [SRC_WIDTH]);
+    LOCAL_ALIGNED_32(int32_t, filter_pos, [MAX_WIDTH + FILTER_PAD]);
+    LOCAL_ALIGNED_32(int16_t, filter, [(MAX_WIDTH + FILTER_PAD) * 40]);
+    LOCAL_ALIGNED_32(int32_t, dst0, [MAX_WIDTH + 8]);
+    LOCAL_ALIGNED_32(int32_t, dst1, [MAX_WIDTH + 8]);
+
+    declare_func(void, SwsContext *c, int16_t *dst, int dstW,
+                 const uint8_t *src, const int16_t *filter,
+                 const int32_t *filterPos, int filterSize);
+
+    ctx = sws_alloc_context();
+    if (!ctx || sws_init_context(ctx, NULL, NULL) < 0) {
+        fail();
+        goto end;
+    }
+
+    randomize_buffers(src, SRC_WIDTH);
+
+    for (fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+        int fs = filter_sizes[fsi];
+
+        /* Keep the negative lobes small enough that the 15-bit
+         * intermediate cannot underflow, like the real filters. */
+        for (i = 0; i < MAX_WIDTH; i++) {
+            filter_pos[i] = rnd() % (SRC_WIDTH - fs + 1);
+            for (j = 0; j < fs; j++)
+                filter[i * fs + j] = (rnd() & 0x3fff) - 0x100;
+        }
+
+        for (bpci = 0; bpci < FF_ARRAY_ELEMS(dst_bpcs); bpci++) {
+            ctx->srcBpc = 8;
+            ctx->dstBpc = dst_bpcs[bpci];
+            ctx->hLumFilterSize = ctx->hChrFilterSize = fs;
+            ff_getSwsFunc(ctx);
+
+            if (check_func(ctx->hcScale, "hscale_8_to_%d_%d",
+                           ctx->dstBpc <= 14 ? 15 : 19, fs)) {
+                for (wi = 0; wi < FF_ARRAY_ELEMS(widths); wi++) {
+                    int w = widths[wi];
+
+                    for (i = w; i < w + FILTER_PAD; i++) {
+                        filter_pos[i] = filter_pos[w - 1];
+                        memcpy(filter + i * fs, filter + (w - 1) * fs,
+                               fs * sizeof(*filter));
+                    }
+
+                    memset(dst0, 0, (MAX_WIDTH + 8) * sizeof(*dst0));
+                    memset(dst1, 0, (MAX_WIDTH + 8) * sizeof(*dst1));
+
+                    call_ref(NULL, (int16_t *)dst0, w, src, filter, filter_pos, fs);
+                    call_new(NULL, (int16_t *)dst1, w, src, filter, filter_pos, fs);
+                    if (memcmp(dst0, dst1, w * (ctx->dstBpc <= 14 ? 2 : 4)))
+                        fail();
+                }
+                bench_new(NULL, (int16_t *)dst1, MAX_WIDTH, src, filter, filter_pos, fs);
+            }
+        }
+    }
+
+end:
+    sws_freeContext(ctx);
+}
+
+#define MAX_VFILTER 16
+
+static void check_yuv2planeX(void)
+{
+    static const int filter_sizes[] = { 2, 4, 8, 16 };
+    int fsi, wi, offset, i;
+    struct SwsContext *ctx;
+    const int16_t *src[MAX_VFILTER];
+
+    LOCAL_ALIGNED_32(int16_t, src_pixels, [MAX_VFILTER * (MAX_WIDTH + 64)]);
+    LOCAL_ALIGNED_32(int16_t, filter, [MAX_VFILTER]);
+    LOCAL_ALIGNED_32(uint8_t, dither, [8]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_WIDTH + 32]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_WIDTH + 32]);
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, const int16_t *filter, int filterSize,
+                      const int16_t **src, uint8_t *dest, int dstW,
+                      const uint8_t *dither, int offset);
+
+    ctx = sws_alloc_context();
+    if (!ctx) {
+        fail();
+        return;
+    }
+    ctx->flags = SWS_BICUBIC | SWS_ACCURATE_RND;
+    if (sws_init_context(ctx, NULL, NULL) < 0) {
+        fail();
+        goto end;
+    }
+    ff_getSwsFunc(ctx);
+
+    for (i = 0; i < MAX_VFILTER * (MAX_WIDTH + 64); i++)
+        src_pixels[i] = rnd() & 0x7fff;
+    for (i = 0; i < MAX_VFILTER; i++)
+        src[i] = src_pixels + i * (MAX_WIDTH + 64);
+    randomize_buffers(dither, 8);
+
+    for (fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+        int fs = filter_sizes[fsi], sum = 0;
+
+        /* 12-bit coefficients adding up to 4096 */
+        for (i = 0; i < fs - 1; i++) {
+            filter[i] = (rnd() % 1024) - 256;
+            sum += filter[i];
+        }
+        filter[fs - 1] = 4096 - sum;
+
+        if (check_func(ctx->yuv2planeX, "yuv2planeX_8_%d", fs)) {
+            for (wi = 0; wi < FF_ARRAY_ELEMS(widths); wi++) {
+                for (offset = 0; offset <= 3; offset += 3) {
+                    memset(dst0, 0, MAX_WIDTH + 32);
+                    memset(dst1, 0, MAX_WIDTH + 32);
+
+                    call_ref(filter, fs, src, dst0, widths[wi], dither, offset);
+                    call_new(filter, fs, src, dst1, widths[wi], dither, offset);
+                    if (memcmp(dst0, dst1, widths[wi]))
+                        fail();
+                }
+            }
+            bench_new(filter, fs, src, dst1, MAX_WIDTH, dither, 0);
+        }
+    }
+
+end:
+    sws_freeContext(ctx);
+}
+
+/* Layout of the vertical filter handed to the MMX-style vertical scalers
+ * (use_mmx_vfilter): one source line pointer and its coefficient per
+ * 16-byte entry, terminated by a NULL pointer. */
+union VFilterData {
+    const int16_t *src;
+    uint16_t coeff[8];
+};
+
+/* The MMX-style vertical scalers trade accuracy for speed (pmulhw), so
+ * they are checked against this model rather than yuv2planeX_8_c(). */
+static void yuv2yuvX_model(const int16_t *filter, int filterSize,
+                           const int16_t **src, uint8_t *dest, int dstW,
+                           const uint8_t *dither, int offset)
+{
+    int16_t start[8];
+    int i, j;
+
+    for (i = 0; i < 8; i++) {
+        int d = offset ? dither[(i + 3) & 7] : dither[i];
+        start[i] = (int16_t)(d + (filterSize - 1) * 8) >> 4;
+    }
+
+    for (i = 0; i < dstW; i++) {
+        int16_t val = start[i & 7];
+        for (j = 0; j < filterSize; j++)
+            val += (src[j][i + offset] * filter[j]) >> 16;
+        dest[i] = av_clip_uint8(val >> 3);
+    }
+}
+
+static void check_yuv2yuvX(void)
+{
+    static const int filter_sizes[] = { 1, 2, 4, 8, 16 };
+    int fsi, wi, offset, i, j;
+    struct SwsContext *ctx;
+    const int16_t *src[MAX_VFILTER];
+    union VFilterData vfilter[MAX_VFILTER + 1];
+
+    LOCAL_ALIGNED_32(int16_t, src_pixels, [MAX_VFILTER * (MAX_WIDTH + 128)]);
+    LOCAL_ALIGNED_32(int16_t, filter, [MAX_VFILTER]);
+    LOCAL_ALIGNED_32(uint8_t, dither, [8]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_WIDTH + 32]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_WIDTH + 32]);
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, const int16_t *filter, int filterSize,
+                      const int16_t **src, uint8_t *dest, int dstW,
+                      const uint8_t *dither, int offset);
+
+    ctx = sws_alloc_context();
+    if (!ctx || sws_init_context(ctx, NULL, NULL) < 0) {
+        fail();
+        goto end;
+    }
+    ff_getSwsFunc(ctx);
+
+    randomize_buffers((uint8_t *)src_pixels, MAX_VFILTER * (MAX_WIDTH + 128) * 2);
+    randomize_buffers((uint8_t *)filter, MAX_VFILTER * 2);
+    randomize_buffers(dither, 8);
+    for (i = 0; i < MAX_VFILTER; i++)
+        src[i] = src_pixels + i * (MAX_WIDTH + 128);
+
+    for (fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+        int fs = filter_sizes[fsi];
+
+        memset(vfilter, 0, sizeof(vfilter));
+        for (i = 0; i < fs; i++) {
+            vfilter[i].src = src[i];
+            for (j = 4; j < 8; j++)
+                vfilter[i].coeff[j] = filter[i];
+        }
+
+        /* with !use_mmx_vfilter, yuv2planeX is a regular yuv2planeX
+         * function, checked by check_yuv2planeX() */
+        if (ctx->use_mmx_vfilter && check_func(ctx->yuv2planeX, "yuv2yuvX_%d", fs)) {
+            for (wi = 0; wi < FF_ARRAY_ELEMS(widths); wi++) {
+                /* offset addresses the V line from the U line pointers,
+                 * see uv_offx2 */
+                for (offset = 0; offset <= 64; offset += 64) {
+                    memset(dst0, 0, MAX_WIDTH + 32);
+                    memset(dst1, 0, MAX_WIDTH + 32);
+
+                    yuv2yuvX_model(filter, fs, src, dst0, widths[wi], dither, offset);
+                    call_new((const int16_t *)vfilter, fs, src, dst1,
+                             widths[wi], dither, offset);
+                    if (memcmp(dst0, dst1, widths[wi]))
+                        fail();
+                }
+            }
+            bench_new((const int16_t *)vfilter, fs, src, dst1, MAX_WIDTH, dither, 0);
+        }
+    }
+
+end:
+    sws_freeContext(ctx);
+}
+
+void checkasm_check_sw_scale(void)
+{
+    check_hscale();
+    report("hscale");
+    check_yuv2planeX();
+    report("yuv2planeX");
+    check_yuv2yuvX();
+    report("yuv2yuvX");
+}
@@ -0,0 +1,200 @@
+/*
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#include "checkasm.h"
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        for (j = 0; j < size; j+=4)       \
+            AV_WN32(buf + j, rnd());      \
+    } while (0)
+
+#define MAX_WIDTH   512
+#define HEIGHT      4
+#define DST_STRIDE  (MAX_WIDTH * 4 + 64)
+
+static const int widths[] = { 32, 40, 42, 64, 100, 128, 255, 512 };
+
+static int16_t coeff(uint64_t c)
+{
+    return c & 0xffff;
+}
+
+/* The MMX converters are not bit-exact with the C ones, so the x86
+ * versions are all checked against this model of their arithmetic. */
+static void yuv2rgb_model(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          uint8_t *dst, int dstStride, int h_size, int alpha)
+{
+    enum AVPixelFormat fmt = c->dstFormat;
+    int vshift = c->srcFormat != AV_PIX_FMT_YUV422P;
+    int depth  = fmt == AV_PIX_FMT_RGB24 || fmt == AV_PIX_FMT_BGR24 ? 3 : 4;
+    int x, y;
+
+    for (y = 0; y < HEIGHT; y++) {
+        const uint8_t *py = src[0] + y * srcStride[0];
+        const uint8_t *pu = src[1] + (y >> vshift) * srcStride[1];
+        const uint8_t *pv = src[2] + (y >> vshift) * srcStride[2];
+        uint8_t *image    = dst + y * dstStride;
+
+        for (x = 0; x < h_size; x++) {
+            int16_t yy = (int16_t)((py[x] << 3) - coeff(c->yOffset));
+            int16_t u  = av_clip_int16((pu[x >> 1] << 3) - coeff(c->uOffset));
+            int16_t v  = av_clip_int16((pv[x >> 1] << 3) - coeff(c->vOffset));
+            int16_t cg = av_clip_int16(((u * coeff(c->ugCoeff)) >> 16) +
+                                       ((v * coeff(c->vgCoeff)) >> 16));
+            int r, g, b;
+
+            yy = (yy * coeff(c->yCoeff)) >> 16;
+            b  = av_clip_uint8(av_clip_int16(yy + ((u * coeff(c->ubCoeff)) >> 16)));
+            r  = av_clip_uint8(av_clip_int16(yy + ((v * coeff(c->vrCoeff)) >> 16)));
+            g  = av_clip_uint8(av_clip_int16(yy + cg));
+
+            switch (fmt) {
+            case AV_PIX_FMT_RGB24:
+                image[0] = r; image[1] = g; image[2] = b;
+                break;
+            case AV_PIX_FMT_BGR24:
+                image[0] = b; image[1] = g; image[2] = r;
+                break;
+            case AV_PIX_FMT_RGB32:
+                image[0] = b; image[1] = g; image[2] = r;
+                image[3] = alpha ? src[3][y * srcStride[3] + x] : 255;
+                break;
+            case AV_PIX_FMT_BGR32:
+                image[0] = r; image[1] = g; image[2] = b;
+                image[3] = alpha ? src[3][y * srcStride[3] + x] : 255;
+                break;
+            }
+            image += depth;
+        }
+    }
+}
+
+static void check_yuv2rgb(enum AVPixelFormat src_fmt, enum AVPixelFormat dst_fmt)
+{
+    int depth = dst_fmt == AV_PIX_FMT_RGB24 || dst_fmt == AV_PIX_FMT_BGR24 ? 3 : 4;
+    int alpha = src_fmt == AV_PIX_FMT_YUVA420P;
+    int wi, tight, i, log_level;
+    struct SwsContext *ctx;
+    const uint8_t *src[4];
+    int src_stride[4] = { MAX_WIDTH, MAX_WIDTH / 2, MAX_WIDTH / 2, MAX_WIDTH };
+
+    LOCAL_ALIGNED_32(uint8_t, src_y, [MAX_WIDTH * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, src_u, [MAX_WIDTH / 2 * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, src_v, [MAX_WIDTH / 2 * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, src_a, [MAX_WIDTH * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_STRIDE * HEIGHT]);
+
+    declare_func(int, SwsContext *c, const uint8_t *src[], int srcStride[],
+                 int srcSliceY, int srcSliceH, uint8_t *dst[], int dstStride[]);
+
+    /* Without SIMD, swscale warns that no accelerated converter exists. */
+    log_level = av_log_get_level();
+    av_log_set_level(AV_LOG_ERROR);
+    ctx = sws_getContext(MAX_WIDTH, HEIGHT, src_fmt, MAX_WIDTH, HEIGHT, dst_fmt,
+                         SWS_BILINEAR, NULL, NULL, NULL);
+    av_log_set_level(log_level);
+    if (!ctx) {
+        fail();
+        return;
+    }
+
+    randomize_buffers(src_y, MAX_WIDTH * HEIGHT);
+    randomize_buffers(src_u, MAX_WIDTH / 2 * HEIGHT);
+    randomize_buffers(src_v, MAX_WIDTH / 2 * HEIGHT);
+    randomize_buffers(src_a, MAX_WIDTH * HEIGHT);
+    src[0] = src_y;
+    src[1] = src_u;
+    src[2] = src_v;
+    src[3] = src_a;
+
+    /* The generic C converter is not what the model describes. */
+    if (check_func(ctx->swscale, "yuv2rgb_%s_%s", av_get_pix_fmt_name(src_fmt),
+                   av_get_pix_fmt_name(dst_fmt)) &&
+        ARCH_X86 && (av_get_cpu_flags() & AV_CPU_FLAG_MMX)) {
+        for (wi = 0; wi < FF_ARRAY_ELEMS(widths); wi++) {
+            int w = widths[wi];
+
+            /* A tight destination stride makes the converters stop short
+             * of a width that is not a multiple of 8. */
+            for (tight = 0; tight <= 1; tight++) {
+                int stride = tight ? w * depth : DST_STRIDE;
+                int h_size = (w + 7) & ~7;
+                uint8_t *dst[4] = { dst1 };
+                int dst_stride[4] = { stride };
+
+                if (h_size * depth > stride)
+                    h_size -= 8;
+
+                for (i = 0; i < DST_STRIDE * HEIGHT; i++)
+                    dst0[i] = dst1[i] = i * 7;
+
+                ctx->dstW = w;
+                yuv2rgb_model(ctx, src, src_stride, dst0, stride, h_size, alpha);
+                call_new(ctx, src, src_stride, 0, HEIGHT, dst, dst_stride);
+                if (memcmp(dst0, dst1, DST_STRIDE * HEIGHT))
+                    fail();
+            }
+        }
+
+        {
+            uint8_t *dst[4] = { dst1 };
+            int dst_stride[4] = { DST_STRIDE };
+
+            ctx->dstW = MAX_WIDTH;
+            bench_new(ctx, src, src_stride, 0, HEIGHT, dst, dst_stride);
+        }
+    }
+
+    sws_freeContext(ctx);
+}
+
+void checkasm_check_sw_yuv2rgb(void)
+{
+    static const enum AVPixelFormat src_fmts[] = {
+        AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P,
+    };
+    static const enum AVPixelFormat dst_fmts[] = {
+        AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24, AV_PIX_FMT_RGB32, AV_PIX_FMT_BGR32,
+    };
+    int i, j;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(src_fmts); i++)
+        for (j = 0; j < FF_ARRAY_ELEMS(dst_fmts); j++)
+            check_yuv2rgb(src_fmts[i], dst_fmts[j]);
+    report("yuv2rgb");
+
+    check_yuv2rgb(AV_PIX_FMT_YUVA420P, AV_PIX_FMT_RGB32);
+    check_yuv2rgb(AV_PIX_FMT_YUVA420P, AV_PIX_FMT_BGR32);
+    report("yuva2rgb");
+}
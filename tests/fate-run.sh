@@ -243,6 +243,55 @@ stream_remux(){
         -f framecrc - || return
 }
 
+# mux with and without async_upload, both trees must be identical
+dashenc(){
+    for async in 0 1; do
+        dashdir="${outdir}/${test}-${async}"
+        rm -rf $dashdir && mkdir -p $dashdir || return
+        ffmpeg "$@" -async_upload $async -f dash -y $(target_path $dashdir)/out.mpd || return
+    done
+    diff -r ${outdir}/${test}-0 ${outdir}/${test}-1 || return
+    for file in $(ls ${outdir}/${test}-1); do
+        do_md5sum ${outdir}/${test}-1/$file
+    done
+    rm -rf ${outdir}/${test}-0 ${outdir}/${test}-1
+}
+
+# mux once and print the final manifest
+dashenc_mpd(){
+    dashdir="${outdir}/${test}-out"
+    rm -rf $dashdir && mkdir -p $dashdir || return
+    ffmpeg "$@" -f dash -y $(target_path $dashdir)/out.mpd || return
+    cat $dashdir/out.mpd
+    rm -rf $dashdir
+}
+
+# write an image sequence through the write pool of the image2 muxer
+img2_write_threads(){
+    imgdir="${outdir}/${test}-out"
+    rm -rf $imgdir && mkdir -p $imgdir || return
+    ffmpeg "$@" -write_threads 4 -f image2 -y $(target_path $imgdir)/%02d.pgm || return
+    for file in $(ls $imgdir); do
+        do_md5sum $imgdir/$file
+    done
+    rm -rf $imgdir
+}
+
+# read a file twice through the persistent cache, then read another one
+# with a cache size limit so that the first one is evicted
+cache_dir(){
+    src=$1
+    cachedir="${outdir}/${test}-out"
+    rm -rf $cachedir && mkdir -p $cachedir || return
+    for url in cache:$src cache:$src cache:file:$src; do
+        opts="-cache_dir $(target_path $cachedir)"
+        test $url = cache:file:$src && opts="$opts -cache_max_size 1"
+        ffmpeg $opts -i $url -f md5 - || return
+        echo "cache files: $(ls $cachedir | wc -l)"
+    done
+    rm -rf $cachedir
+}
+
 lavffatetest(){
     t="${test#lavf-fate-}"
     ref=${base}/ref/lavf-fate/$t
@@ -0,0 +1,25 @@
+# window deletions, HLS playlists and the upload queue limit all go through
+# the upload thread
+FATE_DASHENC-$(call ALLYES, DASH_MUXER MP4_MUXER LAVFI_INDEV TESTSRC_FILTER SINE_FILTER MPEG4_ENCODER MP2FIXED_ENCODER) += fate-dashenc-async_upload
+fate-dashenc-async_upload: CMD = dashenc \
+    -f lavfi -i "sws_flags=+accurate_rnd+bitexact;testsrc=r=25:d=6:s=160x120" \
+    -f lavfi -i "sine=sample_rate=8000:d=6" -map 0 -map 1 \
+    -sws_flags +accurate_rnd+bitexact -pix_fmt yuv420p -c:v mpeg4 -g 25 -idct simple -dct fastint \
+    -c:a mp2fixed -flags +bitexact -fflags +bitexact \
+    -seg_duration 1 -window_size 3 -extra_window_size 1 -hls_playlist 1 -upload_queue_size 2
+
+# availabilityTimeOffset of chunked streaming output: set for chunks shorter
+# than a segment, absent when the chunks are whole segments
+FATE_DASHENC_MPD-$(call ALLYES, DASH_MUXER MP4_MUXER LAVFI_INDEV TESTSRC_FILTER MPEG4_ENCODER) += fate-dashenc-frag_duration fate-dashenc-frag_duration-segment
+fate-dashenc-frag_duration: CMD = dashenc_mpd \
+    -f lavfi -i "testsrc=r=25:d=3:s=160x120" -c:v mpeg4 -g 25 \
+    -flags +bitexact -fflags +bitexact -streaming 1 -use_template 1 -use_timeline 0 \
+    -seg_duration 1 -frag_duration 0.2
+fate-dashenc-frag_duration-segment: CMD = dashenc_mpd \
+    -f lavfi -i "testsrc=r=25:d=3:s=160x120" -c:v mpeg4 -g 25 \
+    -flags +bitexact -fflags +bitexact -streaming 1 -use_template 1 -use_timeline 0 \
+    -seg_duration 1 -frag_duration 1
+
+FATE_FFMPEG-$(HAVE_THREADS) += $(FATE_DASHENC-yes)
+FATE_FFMPEG += $(FATE_DASHENC_MPD-yes)
+fate-dashenc: $(FATE_DASHENC-yes) $(FATE_DASHENC_MPD-yes)
@@ -146,3 +146,9 @@ fate-time_base: $(TARGET_SAMPLES)/mpeg2/dvd_single_frame.vob
 fate-time_base: CMD = md5 -i $(TARGET_SAMPLES)/mpeg2/dvd_single_frame.vob -an -sn -c:v copy -r 25 -time_base 1001:30000 -fflags +bitexact -f mxf
 
 FATE_SAMPLES_FFMPEG-yes += $(FATE_TIME_BASE-yes)
+
+FATE_CACHE_DIR-$(call ALLYES, CACHE_PROTOCOL FILE_PROTOCOL WAV_DEMUXER PCM_S16LE_DECODER) += fate-ffmpeg-cache_dir
+fate-ffmpeg-cache_dir: tests/data/asynth-44100-2.wav
+fate-ffmpeg-cache_dir: CMD = cache_dir $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+
+FATE_FFMPEG-$(HAVE_FCNTL) += $(FATE_CACHE_DIR-yes)
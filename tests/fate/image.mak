@@ -482,5 +482,17 @@ fate-xbm: $(FATE_XBM-yes)
 
 FATE_IMAGE += $(FATE_IMAGE-yes)
 
+# the read-ahead and write pools of the image2 demuxer and muxer
+FATE_IMAGE2_THREADS-$(call ENCDEC, PGMYUV, IMAGE2) += fate-image2-read_ahead
+fate-image2-read_ahead: $(VREF)
+fate-image2-read_ahead: CMD = framecrc -f image2 -c:v pgmyuv -read_ahead 4 -i $(TARGET_PATH)/tests/vsynth1/%02d.pgm
+
+FATE_IMAGE2_THREADS-$(call ENCDEC, PGMYUV, IMAGE2) += fate-image2-write_threads
+fate-image2-write_threads: $(VREF)
+fate-image2-write_threads: CMD = img2_write_threads -f image2 -c:v pgmyuv -i $(TARGET_PATH)/tests/vsynth1/%02d.pgm -frames:v 10 -c:v pgmyuv
+
+FATE_FFMPEG-$(HAVE_THREADS) += $(FATE_IMAGE2_THREADS-yes)
+fate-image2-threads: $(FATE_IMAGE2_THREADS-yes)
+
 FATE_SAMPLES_FFMPEG += $(FATE_IMAGE)
 fate-image: $(FATE_IMAGE)
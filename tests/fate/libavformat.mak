@@ -2,6 +2,12 @@
 #fate-async: libavformat/tests/async$(EXESUF)
 #fate-async: CMD = run libavformat/tests/async
 
+# runs a keep-alive server on the loopback interface
+FATE_LIBAVFORMAT_HTTP-$(HAVE_PTHREADS) += fate-http_pool
+fate-http_pool: libavformat/tests/http_pool$(EXESUF)
+fate-http_pool: CMD = run libavformat/tests/http_pool
+FATE_LIBAVFORMAT-$(CONFIG_HTTP_PROTOCOL) += $(FATE_LIBAVFORMAT_HTTP-yes)
+
 FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy